@@ -0,0 +1,17 @@
+#pragma once
+
+#include <Arduino.h>
+
+// DNS-Antworten für das Captive Portal im Konfigurationsmodus
+//
+// Jede Anfrage nach einer A-Adresse wird mit der IP des Access Points beantwortet, andere
+// Typen (z.B. AAAA) mit einer leeren Antwort ohne Fehler, damit der Client auf IPv4
+// zurückfällt. Reine Paketverarbeitung ohne Netzwerkzugriff, auf dem Host testbar;
+// Empfang und Versand per UDP übernimmt loop().
+
+const uint16_t CAPTIVE_DNS_MAX_PACKET = 512;   // klassisches DNS über UDP
+const uint32_t CAPTIVE_DNS_TTL = 60;           // Sekunden
+
+// Antwort auf 'query' in 'reply' aufbauen. Rückgabe: Länge der Antwort, 0 = Paket verwerfen
+// (keine Anfrage, fehlerhaft oder Puffer zu klein)
+size_t captiveDnsReply(const uint8_t* query, size_t queryLen, uint8_t* reply, size_t replyMax, const uint8_t ip[4]);
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Ablaufsteuerung im Steuerungsmodus: Befehlswarteschlange, Tastendrücke und WLAN-Verbindung
+//
+// Das Modul greift nicht selbst auf die Hardware zu, WLAN, Pulse und LED erreicht es über
+// ControlHal. Auf dem ESP verbindet main.cpp die Funktionen mit WiFi, pulse.h und der LED,
+// die Host-Simulation (test/test_soak) mit einer virtuellen Uhr und GPIO-Beobachtern.
+//
+// Der Verbindungsaufbau nach dem Start blockiert nicht, loop() und damit die Zeitsteuerung
+// laufen währenddessen. Gelingt er nicht oder bricht das WLAN später weg, wird nur neu
+// gestartet, solange die Zeitsteuerung nicht ohne WLAN weiterlaufen kann (keine Uhrzeit).
+
+// Befehle des Rolladen-Attributs (Wert von ID_SHUTTER)
+enum ShutterCommand : uint8_t
+{
+    CMD_UP = 0,
+    CMD_DOWN = 1,
+    CMD_STOP = 2
+};
+
+// Auslöser der Benchmark-Tastendrücke (siehe env:esp12e_pulse_benchmark), wird nicht protokolliert
+const uint8_t CMD_SRC_BENCHMARK = 0;
+
+const uint8_t CMD_QUEUE_SIZE = 8;                  // Zweierpotenz, ein Platz bleibt frei
+const unsigned long WIFI_BOOT_CHECK_INTERVAL = 500; // Verbindungsaufbau nach dem Start
+const uint32_t WIFI_BOOT_ATTEMPTS = 20;
+const unsigned long WIFI_CHECK_INTERVAL = 30000;   // WLAN prüfen, solange es verbunden ist
+const unsigned long WIFI_RECONNECT_INTERVAL = 5000; // Abstand zwischen zwei Reconnect-Versuchen
+const uint32_t WIFI_MAX_RECONNECT_ATTEMPTS = 20;   // danach Neustart
+
+struct ControlHal
+{
+    void (*wifiBegin)();            // Verbindungsaufbau nach dem Start
+    void (*online)();               // erste Verbindung nach dem Start (homee, Webserver)
+    bool (*canRunOffline)();        // Neustart bei fehlendem WLAN vermeiden
+    bool (*wifiConnected)();
+    void (*wifiReconnect)();
+    void (*restart)();              // kehrt auf dem ESP nicht zurück
+    bool (*pulseReady)();           // kein Puls aktiv und Mindestpause abgelaufen
+    void (*press)(uint8_t command); // Tastendruck starten
+    void (*ledOff)();
+    void (*ledToggle)();
+};
+
+// Warteschlange leeren und Verbindungsaufbau starten (auch nach einem simulierten Neustart)
+void controlBegin(const ControlHal& hal);
+void controlLoop();
+
+// Befehl aus den Callbacks (homee, Zeitsteuerung) übernehmen; false, wenn er wegen "disabled"
+// abgewiesen oder wegen voller Warteschlange verworfen wurde (beides steht in der Historie)
+bool controlSubmit(uint8_t command, uint8_t source);
+void controlSetDisabled(bool disabled);
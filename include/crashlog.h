@@ -0,0 +1,30 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Loop-Watchdog und Absturzprotokoll
+//
+// loop() und die asynchronen Callbacks hinterlassen Trace-Punkte in einem kleinen Ringpuffer.
+// Ein Ticker prüft, ob loop() länger als die Schwelle nicht zurückgekehrt ist. Der Ticker läuft
+// nur, wenn loop() yieldet (z.B. in delay()); Hänger ohne yield() beendet der WDT des Core,
+// dafür liegt dann kein Hänger-Kontext vor. Bei einer Exception, einem Soft-WDT oder einem erkannten Hänger werden Reset-Grund,
+// letzte Trace-Punkte, ein Auszug des Stacks und die Loop-Statistik im RTC-Speicher abgelegt
+// und nach dem Neustart über /crash bzw. das homee-Attribut gemeldet.
+
+enum TracePoint : uint8_t
+{
+    TRACE_LOOP     = 1,
+    TRACE_HOMEE    = 2,   // homee-Callback
+    TRACE_WEB      = 3,   // Webserver-Handler
+    TRACE_SCHEDULE = 4,   // Zeitsteuerung
+    TRACE_MOVE     = 5,   // Tastendruck
+    TRACE_STALL    = 6    // Hänger erkannt
+};
+
+void crashlogBegin(unsigned long stallThresholdMs);
+void crashlogLoop();            // zu Beginn jedes loop()-Durchlaufs
+void traceEvent(uint8_t point);
+
+// Reset-Grund des letzten Neustarts (REASON_* aus user_interface.h)
+uint32_t crashlogResetReason();
+String crashlogReport();
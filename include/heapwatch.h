@@ -0,0 +1,20 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Heap-Messung der homee-Anbindung
+//
+// Gemessen werden der Heap der Node-Beschreibung (setupHomee) und der größte vorübergehende
+// Verbrauch innerhalb eines loop()-Durchlaufs. Dazwischen laufen die asynchronen Callbacks,
+// darunter der homee-Handshake, bei dem die Bibliothek die Node serialisiert. Die Werte unter
+// /heap dienen dem Vorher/Nachher-Vergleich bei Änderungen an der homee-Anbindung.
+//
+// Mit -DUMM_STATS_FULL (env:esp12e_heap_watch) führt umm_malloc den Tiefststand bei jeder
+// Allokation nach, dann werden auch Spitzen innerhalb der Callbacks erfasst. Ohne das Flag
+// wird nur in loop() abgetastet, der Spitzenwert ist dann eine Untergrenze.
+
+const uint32_t HEAP_WATCH_EVENT_BYTES = 1024;   // ab diesem Verbrauch als Ereignis zählen
+
+void heapWatchSetupCost(uint32_t bytes);        // Heap der Node-Beschreibung
+void heapWatchLoop();                           // am Ende jedes loop()-Durchlaufs
+String heapWatchReport();
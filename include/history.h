@@ -0,0 +1,68 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Ereignis-Historie auf LittleFS
+//
+// Feste 12-Byte-Datensätze werden im RAM gepuffert und blockweise an das aktuelle Segment
+// angehängt (schont den Flash). Die Segmente /hist/seg<N>.bin bilden einen Ring, das älteste
+// wird überschrieben. Die Zeitstempel im Log fallen nie, daher sind Bereichsabfragen per
+// binärer Suche über den Segment-Index und innerhalb eines Segments möglich.
+
+// Auslöser eines Ereignisses
+enum HistorySource : uint8_t
+{
+    HIST_SRC_HOMEE    = 1,
+    HIST_SRC_SCHEDULE = 2,
+    HIST_SRC_SYSTEM   = 3
+};
+
+// Ergebnis eines Befehls
+enum HistoryResult : uint8_t
+{
+    HIST_RES_EXECUTED = 0,  // Tastendruck ausgeführt
+    HIST_RES_REJECTED = 1,  // abgewiesen (z.B. "disabled" gesetzt)
+    HIST_RES_DROPPED  = 2   // verworfen (Warteschlange voll)
+};
+
+struct __attribute__((packed)) HistoryRecord
+{
+    uint32_t time;     // Unix-Zeit, solange keine Uhrzeit bekannt ist fortlaufende Sekunden
+    uint8_t source;    // HistorySource
+    uint8_t command;   // ShutterCommand
+    uint8_t result;    // HistoryResult
+    uint8_t reserved[5];
+};
+
+static_assert(sizeof(HistoryRecord) == 12, "HistoryRecord must stay 12 bytes");
+
+// Lese-Position für das Streamen einer Abfrage, überlebt das Rotieren der Segmente
+struct HistoryCursor
+{
+    uint32_t segmentSeq;  // Sequenznummer des Segments
+    uint16_t record;      // Index des nächsten Datensatzes im Segment
+    uint32_t to;          // Ende des Zeitbereichs (inklusive)
+    bool done;
+};
+
+const uint8_t HISTORY_SEGMENTS = 8;
+const uint16_t HISTORY_RECORDS_PER_SEGMENT = 256;
+const uint8_t HISTORY_BATCH_SIZE = 16;
+const uint8_t HISTORY_FLUSH_THRESHOLD = 12;          // Reserve für Einträge bis zum nächsten loop()
+const unsigned long HISTORY_FLUSH_INTERVAL = 300000; // spätestens nach 5 Minuten schreiben
+
+void historyBegin();
+// historyAdd() und die Abfrage dürfen aus Callbacks (homee, Webserver) aufgerufen werden und
+// schreiben nie in den Flash; das übernehmen historyLoop() bzw. historyFlush() aus loop().
+void historyAdd(uint8_t source, uint8_t command, uint8_t result);
+void historyFlush();
+void historyLoop();
+
+// Abfrage: Cursor auf den ersten Datensatz mit time >= from setzen, dann blockweise mit
+// historyRead lesen, bis cursor.done gesetzt ist. Es liegt nie mehr als ein Block im RAM.
+void historyQuery(uint32_t from, uint32_t to, HistoryCursor& cursor);
+size_t historyRead(HistoryCursor& cursor, HistoryRecord* records, size_t maxRecords);
+
+const char* historySourceName(uint8_t source);
+const char* historyCommandName(uint8_t command);
+const char* historyResultName(uint8_t result);
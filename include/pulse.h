@@ -0,0 +1,34 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Tastendruck-Pulse per Hardware-Timer (timer1)
+//
+// Die Ausgänge sind einmalig als Open-Drain konfiguriert und im Ruhezustand freigegeben
+// (HIGH = hochohmig), die Tasten der KLI 310 funktionieren also weiterhin. pulseStart() zieht
+// den Pin per Registerzugriff auf LOW und startet timer1, die ISR gibt ihn wieder frei.
+// Die Pulsbreite hängt damit nicht mehr von delay(), WiFi-Interrupts oder Logging ab.
+// Die tatsächliche Breite wird über den CPU-Zykluszähler gemessen und ausgewertet.
+
+const uint8_t PULSE_HIST_BUCKETS = 16;
+const uint32_t PULSE_HIST_STEP_US = 10;   // Abweichung je Histogramm-Klasse
+
+struct PulseStats
+{
+    uint32_t count;
+    uint32_t minUs;
+    uint32_t maxUs;
+    uint64_t sumUs;
+    uint32_t hist[PULSE_HIST_BUCKETS];    // Abweichung von der Sollbreite, letzte Klasse = Rest
+};
+
+void pulseBegin(const uint8_t* pins, uint8_t count, unsigned long gapMs);
+bool pulseStart(uint8_t pin, uint32_t widthUs);
+
+// Abschluss auswerten, aus loop() aufrufen; true, wenn gerade ein Puls beendet wurde
+bool pulsePoll();
+bool pulseReady();                       // kein Puls aktiv und Mindestpause abgelaufen
+
+uint32_t pulseLastWidthUs();
+const PulseStats& pulseStats();
+String pulseReport();
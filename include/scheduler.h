@@ -0,0 +1,60 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Lokale Zeitsteuerung
+//
+// Feste Uhrzeiten oder Sonnenauf-/-untergang mit Offset, jeweils mit Wochentagsmaske.
+// Für jeden Eintrag wird der nächste Auslösezeitpunkt vorberechnet, loop() vergleicht nur
+// noch die aktuelle Zeit mit dem frühesten davon. Die Uhrzeit kommt per NTP, bei Ausfall
+// läuft die Systemuhr ab der letzten Synchronisation weiter.
+
+enum ScheduleType : uint8_t
+{
+    SCHED_OFF     = 0,
+    SCHED_FIXED   = 1,  // minutes = Minuten nach Mitternacht (Ortszeit)
+    SCHED_SUNRISE = 2,  // minutes = Offset zum Sonnenaufgang
+    SCHED_SUNSET  = 3   // minutes = Offset zum Sonnenuntergang
+};
+
+struct ScheduleEntry
+{
+    uint8_t type;      // ScheduleType
+    uint8_t command;   // ShutterCommand
+    uint8_t weekdays;  // Bit 0 = Sonntag ... Bit 6 = Samstag (wie tm_wday)
+    uint8_t reserved;
+    int16_t minutes;
+};
+
+const uint8_t SCHEDULE_ENTRIES = 6;
+const uint8_t SCHEDULE_ALL_DAYS = 0x7F;
+
+// zuletzt abgearbeitete Termine im RTC-Benutzerspeicher (4-Byte-Blöcke), hinter dem CrashContext
+const uint32_t SCHEDULE_RTC_OFFSET = 48;
+
+struct ScheduleConfig
+{
+    float latitude;
+    float longitude;
+    char timezone[40];    // POSIX-TZ, z.B. "CET-1CEST,M3.5.0,M10.5.0/3"
+    char ntp_server[40];
+    ScheduleEntry entries[SCHEDULE_ENTRIES];
+    uint8_t checkValue;
+};
+
+extern ScheduleConfig scheduleConfig;
+
+typedef void (*ScheduleCallback)(uint8_t command);
+
+// Konfiguration liegt im EEPROM hinter ConfigData, mit eigenem Prüfbyte
+void scheduleLoadConfig(uint16_t eepromAddr);
+void scheduleStoreConfig(uint16_t eepromAddr); // nur EEPROM.put, commit macht der Aufrufer
+
+void scheduleBegin(ScheduleCallback callback);
+void scheduleLoop();
+
+// Uhrzeit gesetzt und mindestens ein Termin geplant, die Zeitsteuerung läuft auch ohne WLAN
+bool scheduleRunning();
+
+// nächster Auslösezeitpunkt eines Eintrags nach 'after' (Unix-Zeit), 0 wenn keiner
+time_t scheduleNextFire(const ScheduleEntry& entry, time_t after);
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Sonnenauf- und -untergang (Algorithmus aus dem "Almanac for Computers", Genauigkeit ca. 1-2 min)
+//
+// Ergebnis in Minuten nach Mitternacht UTC für das angegebene (UTC-)Datum. Der Wert kann
+// außerhalb von 0..1439 liegen, wenn das Ereignis auf den Vor- oder Folgetag fällt.
+// Rückgabe false, wenn die Sonne an diesem Tag nicht auf- bzw. untergeht (Polartag/-nacht).
+bool sunriseUtc(int year, int month, int day, double latitude, double longitude, int16_t& minutes);
+bool sunsetUtc(int year, int month, int day, double latitude, double longitude, int16_t& minutes);
+
+// Tage seit 1970-01-01 für ein Datum im gregorianischen Kalender
+int32_t daysFromCivil(int year, int month, int day);
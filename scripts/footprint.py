@@ -0,0 +1,138 @@
+# Speicherbedarf der Firmware (IRAM / DRAM / Flash) pruefen
+#
+# Nach jedem Build werden die Summen je Speicherbereich gegen die Budgets aus
+# platformio.ini (custom_budget_*) geprueft, bei Ueberschreitung schlaegt der
+# Build fehl. Die ausfuehrliche Aufstellung je Funktion und Modul liefert
+#
+#   pio run -t footprint
+#
+# ESP8266 Speicherbereiche (Core 3.x, Standard-MMU):
+#   IRAM  0x40100000 - 0x40108000  .text, .text1 (Code, der aus dem RAM ausgefuehrt wird)
+#   DRAM  0x3FFE8000 - 0x40000000  .data, .rodata, .bss, Heap
+#   Flash 0x40200000 - 0x40300000  .irom0.text (ueber den Cache gelesen)
+#
+# Im Flash-Image liegen alle ladbaren Sektionen: .irom0.text direkt, .text, .text1,
+# .data und .rodata werden beim Start von dort ins RAM kopiert (.bss nicht).
+
+import os
+import re
+import subprocess
+from collections import defaultdict
+
+Import("env")
+
+REGIONS = (
+    ("iram", 0x40100000, 0x40108000),
+    ("dram", 0x3FFE8000, 0x40000000),
+    ("flash", 0x40200000, 0x40300000),
+)
+
+# Sektionen, die in die Summen je Bereich einfliessen (Ausgabesektionen des Core-Linkerskripts)
+SECTIONS = {
+    "iram": (".text", ".text1"),
+    "dram": (".data", ".rodata", ".bss"),
+    "flash": (".irom0.text", ".text", ".text1", ".data", ".rodata"),
+}
+
+
+def _tool(name):
+    # $SIZETOOL ist z.B. ".../xtensa-lx106-elf-size", nm liegt daneben
+    sizetool = env.subst("$SIZETOOL")
+    return re.sub(r"size(\.exe)?$", name + r"\1", sizetool)
+
+
+def _run(args):
+    # die Toolchain liegt nur im PATH der PlatformIO-Umgebung, nicht in dem des Prozesses
+    return subprocess.check_output(
+        args, universal_newlines=True, env=dict(os.environ, PATH=env["ENV"]["PATH"]))
+
+
+def _budget(region):
+    value = env.GetProjectOption("custom_budget_" + region, "")
+    return int(value, 0) if value else None
+
+
+def _region_of(addr):
+    for name, start, end in REGIONS:
+        if start <= addr < end:
+            return name
+    return None
+
+
+def _section_sizes(elf):
+    out = _run([_tool("size"), "-A", elf])
+    sizes = defaultdict(int)
+    for line in out.splitlines():
+        parts = line.split()
+        if len(parts) < 3 or not parts[1].isdigit():
+            continue
+        for region, names in SECTIONS.items():
+            if parts[0] in names:
+                sizes[region] += int(parts[1])
+    return sizes
+
+
+def _symbols(elf):
+    # Zeilen: <addr> <size> <type> <name>\t<file>:<line>
+    out = _run([_tool("nm"), "-S", "-C", "-l", "--size-sort", elf])
+    for line in out.splitlines():
+        head, _, location = line.partition("\t")
+        parts = head.split(None, 3)
+        if len(parts) < 4:
+            continue
+        addr, size, _, name = parts
+        region = _region_of(int(addr, 16))
+        if region is None:
+            continue
+        module = os.path.basename(location.rsplit(":", 1)[0]) if location else "(lib/sdk)"
+        yield region, int(size, 16), name, module
+
+
+def check_budgets(target, source, env):
+    elf = str(target[0])
+    sizes = _section_sizes(elf)
+    failed = False
+    print("Speicherbudget:")
+    for region, _, _ in REGIONS:
+        budget = _budget(region)
+        used = sizes.get(region, 0)
+        if budget is None:
+            print("  %-5s %8d bytes  (kein Budget gesetzt)" % (region.upper(), used))
+            continue
+        state = "ok" if used <= budget else "UEBERSCHRITTEN"
+        print("  %-5s %8d / %8d bytes  %s" % (region.upper(), used, budget, state))
+        failed = failed or used > budget
+    if failed:
+        env.Exit(1)
+
+
+def report(target, source, env):
+    elf = env.subst("$BUILD_DIR/${PROGNAME}.elf")
+    top = int(env.GetProjectOption("custom_footprint_top", "25"))
+    per_module = defaultdict(lambda: defaultdict(int))
+    per_symbol = defaultdict(list)
+    for region, size, name, module in _symbols(elf):
+        per_module[region][module] += size
+        per_symbol[region].append((size, name, module))
+
+    for region, _, _ in REGIONS:
+        print()
+        print("=== %s je Modul ===" % region.upper())
+        for module, size in sorted(per_module[region].items(), key=lambda m: -m[1]):
+            print("  %8d  %s" % (size, module))
+        print("=== %s groesste Symbole (Top %d) ===" % (region.upper(), top))
+        for size, name, module in sorted(per_symbol[region], reverse=True)[:top]:
+            print("  %8d  %-60s %s" % (size, name[:60], module))
+    print()
+    check_budgets([elf], source, env)
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", check_budgets)
+
+env.AddCustomTarget(
+    name="footprint",
+    dependencies="$BUILD_DIR/${PROGNAME}.elf",
+    actions=[report],
+    title="Footprint",
+    description="IRAM/DRAM/Flash je Funktion und Modul",
+)
@@ -0,0 +1,115 @@
+#include "captivedns.h"
+
+const size_t DNS_HEADER_SIZE = 12;
+const size_t DNS_ANSWER_SIZE = 16;         // Namenszeiger, Typ, Klasse, TTL, Länge, IPv4
+const size_t DNS_MAX_NAME = 255;
+const uint16_t DNS_FLAG_QR = 0x8000;       // Antwort
+const uint16_t DNS_FLAG_AA = 0x0400;       // autoritativ
+const uint16_t DNS_FLAG_RD = 0x0100;       // Rekursion gewünscht (aus der Anfrage übernommen)
+const uint16_t DNS_OPCODE_MASK = 0x7800;
+const uint16_t DNS_RCODE_NOTIMP = 4;
+const uint16_t DNS_TYPE_A = 1;
+const uint16_t DNS_TYPE_ANY = 255;
+const uint16_t DNS_CLASS_IN = 1;
+const uint16_t DNS_CLASS_ANY = 255;
+const uint16_t DNS_NAME_POINTER = 0xC000 | DNS_HEADER_SIZE;   // Name der Frage
+
+static uint16_t read16(const uint8_t* p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static void write16(uint8_t* p, uint16_t value)
+{
+    p[0] = value >> 8;
+    p[1] = value & 0xFF;
+}
+
+static void writeCounts(uint8_t* reply, uint16_t answers)
+{
+    write16(reply + 6, answers);
+    write16(reply + 8, 0);
+    write16(reply + 10, 0);    // EDNS-Eintrag der Anfrage wird nicht übernommen
+}
+
+size_t captiveDnsReply(const uint8_t* query, size_t queryLen, uint8_t* reply, size_t replyMax, const uint8_t ip[4])
+{
+    if (queryLen < DNS_HEADER_SIZE || queryLen > CAPTIVE_DNS_MAX_PACKET || replyMax < DNS_HEADER_SIZE)
+    {
+        return 0;
+    }
+
+    uint16_t flags = read16(query + 2);
+    if (flags & DNS_FLAG_QR)
+    {
+        return 0; // keine Anfrage, nie auf Antworten antworten
+    }
+
+    // nur Standardabfragen, sonst NOTIMP ohne Frage
+    if (flags & DNS_OPCODE_MASK)
+    {
+        memcpy(reply, query, 2);
+        write16(reply + 2, DNS_FLAG_QR | (flags & (DNS_OPCODE_MASK | DNS_FLAG_RD)) | DNS_RCODE_NOTIMP);
+        write16(reply + 4, 0);
+        writeCounts(reply, 0);
+        return DNS_HEADER_SIZE;
+    }
+
+    if (read16(query + 4) != 1)
+    {
+        return 0; // genau eine Frage, wie bei allen gängigen Resolvern
+    }
+
+    // Name der Frage: Labels bis zur abschließenden Null, ohne Kompression
+    size_t pos = DNS_HEADER_SIZE;
+    for (;;)
+    {
+        if (pos >= queryLen || pos - DNS_HEADER_SIZE >= DNS_MAX_NAME)
+        {
+            return 0;
+        }
+        uint8_t label = query[pos];
+        if (label == 0)
+        {
+            pos++;
+            break;
+        }
+        if (label & 0xC0)
+        {
+            return 0;
+        }
+        pos += 1 + label;
+    }
+    if (pos + 4 > queryLen)
+    {
+        return 0;
+    }
+
+    uint16_t type = read16(query + pos);
+    uint16_t cls = read16(query + pos + 2);
+    size_t questionEnd = pos + 4;
+    bool answer = (type == DNS_TYPE_A || type == DNS_TYPE_ANY) && (cls == DNS_CLASS_IN || cls == DNS_CLASS_ANY);
+
+    size_t replyLen = questionEnd + (answer ? DNS_ANSWER_SIZE : 0);
+    if (replyLen > replyMax)
+    {
+        return 0;
+    }
+
+    memcpy(reply, query, questionEnd);
+    write16(reply + 2, DNS_FLAG_QR | DNS_FLAG_AA | (flags & DNS_FLAG_RD));
+    writeCounts(reply, answer ? 1 : 0);
+
+    if (answer)
+    {
+        uint8_t* a = reply + questionEnd;
+        write16(a, DNS_NAME_POINTER);
+        write16(a + 2, DNS_TYPE_A);
+        write16(a + 4, DNS_CLASS_IN);
+        write16(a + 6, CAPTIVE_DNS_TTL >> 16);
+        write16(a + 8, CAPTIVE_DNS_TTL & 0xFFFF);
+        write16(a + 10, 4);
+        memcpy(a + 12, ip, 4);
+    }
+    return replyLen;
+}
@@ -0,0 +1,184 @@
+#include "control.h"
+#include "history.h"
+
+static ControlHal hal;
+static bool shutterDisabled = false;
+
+// Befehlswarteschlange zwischen den Callbacks (homee, Zeitsteuerung) und loop()
+// Die Befehle werden in Eingangsreihenfolge abgearbeitet (vorher Flags, dadurch wurde z.B.
+// "Stop, dann Hoch" als "Hoch, dann Stop" ausgeführt und Wiederholungen gingen verloren).
+// Ein Eintrag enthält den Befehl (untere 4 Bit) und den Auslöser (HistorySource, obere 4 Bit).
+static volatile uint8_t cmdQueue[CMD_QUEUE_SIZE];
+static volatile uint8_t cmdQueueHead = 0; // nächster Schreibindex (Callback)
+static volatile uint8_t cmdQueueTail = 0; // nächster Leseindex (loop)
+
+enum WifiState : uint8_t
+{
+    WIFI_STARTING,       // Verbindungsaufbau nach dem Start
+    WIFI_CONNECTED,
+    WIFI_RECONNECTING
+};
+
+static unsigned long lastWifiCheckTime = 0;
+static uint32_t wifiConnectAttempts = 0;  // Anzahl der Versuche, sich mit dem WLAN zu verbinden
+static WifiState wifiState = WIFI_STARTING;
+static bool online = false;               // hal.online() seit dem Start aufgerufen
+
+// Benchmark-Tastendrücke nicht in die Historie schreiben (sonst ca. 1800 Einträge pro Stunde)
+static void logCommand(uint8_t source, uint8_t command, uint8_t result)
+{
+    if (source != CMD_SRC_BENCHMARK)
+    {
+        historyAdd(source, command, result);
+    }
+}
+
+static bool pushCommand(uint8_t command, uint8_t source)
+{
+    uint8_t next = (cmdQueueHead + 1) & (CMD_QUEUE_SIZE - 1);
+    if (next == cmdQueueTail)
+    {
+        return false; // Warteschlange voll
+    }
+    cmdQueue[cmdQueueHead] = (source << 4) | (command & 0x0F);
+    cmdQueueHead = next;
+    return true;
+}
+
+static bool popCommand(uint8_t& command, uint8_t& source)
+{
+    if (cmdQueueTail == cmdQueueHead)
+    {
+        return false;
+    }
+    uint8_t entry = cmdQueue[cmdQueueTail];
+    cmdQueueTail = (cmdQueueTail + 1) & (CMD_QUEUE_SIZE - 1);
+    command = entry & 0x0F;
+    source = entry >> 4;
+    return true;
+}
+
+void controlBegin(const ControlHal& halFunctions)
+{
+    hal = halFunctions;
+    cmdQueueHead = 0;
+    cmdQueueTail = 0;
+    lastWifiCheckTime = millis();
+    wifiConnectAttempts = 0;
+    wifiState = WIFI_STARTING;
+    online = false;
+
+    Serial.print("Connecting ");
+    hal.wifiBegin();
+}
+
+void controlSetDisabled(bool disabled)
+{
+    shutterDisabled = disabled;
+}
+
+bool controlSubmit(uint8_t command, uint8_t source)
+{
+    if (command != CMD_STOP && shutterDisabled)  //Stop will also work if Shutter is disabled
+    {
+        logCommand(source, command, HIST_RES_REJECTED);
+        return false;
+    }
+
+    if (!pushCommand(command, source))
+    {
+        Serial.printf_P(PSTR("Command queue full, command dropped: %u\n"), command);
+        logCommand(source, command, HIST_RES_DROPPED);
+        return false;
+    }
+    return true;
+}
+
+// Zeitvergleiche immer als Differenz (millis() - t), damit der Überlauf nach ~49 Tagen
+// korrekt behandelt wird. Im Reconnect-Fall wird nicht blockiert: WiFi.reconnect() braucht
+// einige Sekunden bis zur Assoziierung, ein erneuter Aufruf nach nur 500ms bricht den
+// laufenden Versuch ab und führte zuverlässig zum Neustart.
+static void superviseWifi()
+{
+    unsigned long checkInterval = WIFI_CHECK_INTERVAL;
+    if (wifiState == WIFI_STARTING)
+    {
+        checkInterval = WIFI_BOOT_CHECK_INTERVAL;
+    }
+    else if (wifiState == WIFI_RECONNECTING)
+    {
+        checkInterval = WIFI_RECONNECT_INTERVAL;
+    }
+    if (millis() - lastWifiCheckTime < checkInterval)
+    {
+        return;
+    }
+    lastWifiCheckTime = millis();
+
+    if (hal.wifiConnected())
+    {
+        if (wifiState == WIFI_STARTING)
+        {
+            Serial.println(" success");
+        }
+        else if (wifiState == WIFI_RECONNECTING)
+        {
+            Serial.println("WiFi reconnected after " + String(wifiConnectAttempts) + " attempts");
+        }
+        wifiState = WIFI_CONNECTED;
+        wifiConnectAttempts = 0; // WLAN-Verbindung erfolgreich
+        hal.ledOff(); // LED ausschalten, wenn WLAN verbunden ist
+        if (!online)
+        {
+            online = true;
+            hal.online();
+        }
+        return;
+    }
+
+    if (wifiState == WIFI_STARTING)
+    {
+        if (++wifiConnectAttempts < WIFI_BOOT_ATTEMPTS)
+        {
+            hal.ledToggle(); // LED umschalten
+            Serial.print(".");
+            return;
+        }
+        Serial.println(" failed");
+        hal.ledOff();
+        wifiConnectAttempts = WIFI_MAX_RECONNECT_ATTEMPTS; // weiter wie nach erfolglosen Reconnects
+    }
+
+    if (wifiConnectAttempts >= WIFI_MAX_RECONNECT_ATTEMPTS)
+    {
+        if (!hal.canRunOffline())
+        {
+            Serial.println("No WiFi after " + String(wifiConnectAttempts) + " attempts and no time for the schedule. Restarting ESP8266...");
+            hal.restart(); // ESP8266 zurücksetzen, wenn keine Verbindung hergestellt werden kann
+            return;
+        }
+        // Zeitsteuerung läuft auf der internen Uhr weiter, ein Neustart würde die Uhrzeit löschen
+        Serial.println("No WiFi after " + String(wifiConnectAttempts) + " attempts, schedule keeps running on the internal clock");
+        wifiConnectAttempts = 0;
+    }
+
+    // Bei Verbindungsverlust erneut verbinden
+    wifiState = WIFI_RECONNECTING;
+    Serial.println("WiFi connection lost. Reconnecting...");
+    hal.ledToggle(); // LED blinken lassen, um den Verbindungsverlust anzuzeigen
+    hal.wifiReconnect();
+    wifiConnectAttempts++;
+}
+
+void controlLoop()
+{
+    superviseWifi();
+
+    // nur ein Tastendruck gleichzeitig, mit Mindestpause dazwischen
+    uint8_t command, source;
+    if (hal.pulseReady() && popCommand(command, source))
+    {
+        hal.press(command);
+        logCommand(source, command, HIST_RES_EXECUTED);
+    }
+}
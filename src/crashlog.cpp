@@ -0,0 +1,281 @@
+#include "crashlog.h"
+#include "scheduler.h"
+
+#include <Ticker.h>
+
+extern "C" {
+#include <user_interface.h>
+}
+
+const uint32_t CRASHLOG_MAGIC = 0x43525348; // "CRSH"
+const uint32_t CRASHLOG_RTC_OFFSET = 0;     // in 4-Byte-Blöcken, RTC-Benutzerbereich
+const uint8_t TRACE_SIZE = 8;               // Zweierpotenz
+const uint8_t STACK_WORDS = 16;
+const unsigned long WATCHDOG_INTERVAL = 100;
+
+struct TraceEntry
+{
+    uint32_t ms;
+    uint32_t point;
+};
+
+// 64 Bit für Zähler und Summe, 32 Bit liefen nach wenigen Tagen bzw. ca. 49 Tagen über und
+// verfälschten den Mittelwert
+struct LoopStats
+{
+    uint64_t count;
+    uint64_t totalMs;
+    uint32_t maxMs;
+    uint32_t stalls;
+};
+
+// Inhalt des RTC-Speichers, muss ein Vielfaches von 4 Byte sein
+struct CrashContext
+{
+    uint32_t magic;
+    uint32_t reason;       // 0 = Hänger erkannt, sonst REASON_* der Exception
+    uint32_t exccause;
+    uint32_t epc1;
+    uint32_t excvaddr;
+    uint32_t stackAddr;
+    uint32_t stackWords;
+    uint32_t traceHead;
+    LoopStats stats;
+    TraceEntry trace[TRACE_SIZE];
+    uint32_t stack[STACK_WORDS];
+};
+
+// ab Benutzerblock 64 (0x60001200) legt eboot das OTA-Kommando ab
+static_assert(CRASHLOG_RTC_OFFSET * 4 + sizeof(CrashContext) <= 256, "CrashContext overlaps eboot command");
+static_assert(CRASHLOG_RTC_OFFSET * 4 + sizeof(CrashContext) <= SCHEDULE_RTC_OFFSET * 4, "CrashContext overlaps schedule state");
+static_assert(sizeof(CrashContext) % 4 == 0, "CrashContext must be word aligned");
+
+static TraceEntry trace[TRACE_SIZE];
+static volatile uint32_t traceHead = 0;
+static LoopStats stats;
+static volatile unsigned long loopStartMs = 0;
+static unsigned long stallThreshold = 1000;
+static volatile bool stallActive = false;
+static volatile bool stallLogged = true;
+static Ticker watchdogTicker;
+
+static uint32_t resetReason = REASON_DEFAULT_RST;
+static CrashContext lastCrash;         // Kontext des vorherigen Laufs
+static bool lastCrashValid = false;
+
+static void fillContext(CrashContext& ctx)
+{
+    ctx.magic = CRASHLOG_MAGIC;
+    ctx.traceHead = traceHead;
+    ctx.stats = stats;
+    memcpy(ctx.trace, trace, sizeof(trace));
+}
+
+static void saveContext(CrashContext& ctx)
+{
+    ESP.rtcUserMemoryWrite(CRASHLOG_RTC_OFFSET, (uint32_t*)&ctx, sizeof(CrashContext));
+}
+
+static void clearContext()
+{
+    uint32_t clear = 0;
+    ESP.rtcUserMemoryWrite(CRASHLOG_RTC_OFFSET, &clear, sizeof(clear));
+}
+
+// Wird vom Core bei Exception und Soft-WDT aufgerufen (core_esp8266_postmortem.cpp)
+extern "C" void custom_crash_callback(struct rst_info* rst_info, uint32_t stack, uint32_t stack_end)
+{
+    static CrashContext ctx;   // nicht auf den (defekten) Stack legen
+    memset(&ctx, 0, sizeof(ctx));
+    fillContext(ctx);
+    ctx.reason = rst_info->reason;
+    ctx.exccause = rst_info->exccause;
+    ctx.epc1 = rst_info->epc1;
+    ctx.excvaddr = rst_info->excvaddr;
+    ctx.stackAddr = stack;
+    ctx.stackWords = min((uint32_t)STACK_WORDS, (stack_end - stack) / 4);
+    memcpy(ctx.stack, (const void*)stack, ctx.stackWords * 4);
+    saveContext(ctx);
+}
+
+// Läuft als os_timer im SYS-Kontext, also nur, wenn loop() die Kontrolle abgibt (delay(),
+// yield()). Ein Hänger in einer Schleife ohne yield() wird hier nicht erkannt, ihn beenden
+// Soft- bzw. Hardware-WDT des Core.
+static void watchdogCheck()
+{
+    // setup() darf länger dauern, überwacht wird erst ab dem ersten loop()-Durchlauf
+    if (stats.count == 0 || stallActive || (millis() - loopStartMs) < stallThreshold)
+    {
+        return;
+    }
+
+    stallActive = true;
+    stallLogged = false;
+    stats.stalls++;
+    traceEvent(TRACE_STALL);
+
+    // Kontext sichern: endet derselbe Hänger später ohne Callback im Reset (Hardware-WDT,
+    // nachdem er nicht mehr yieldet), ist wenigstens der Stand bei seiner Erkennung vorhanden
+    static CrashContext ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    fillContext(ctx);
+    saveContext(ctx);
+}
+
+void crashlogBegin(unsigned long stallThresholdMs)
+{
+    stallThreshold = stallThresholdMs;
+
+    const rst_info* info = ESP.getResetInfoPtr();
+    resetReason = info->reason;
+
+    ESP.rtcUserMemoryRead(CRASHLOG_RTC_OFFSET, (uint32_t*)&lastCrash, sizeof(CrashContext));
+    bool abnormal = (resetReason == REASON_EXCEPTION_RST || resetReason == REASON_SOFT_WDT_RST || resetReason == REASON_WDT_RST);
+    lastCrashValid = abnormal && (lastCrash.magic == CRASHLOG_MAGIC);
+    if (lastCrashValid && resetReason == REASON_WDT_RST)
+    {
+        // Hardware-WDT ruft keinen Callback auf; ein Kontext liegt nur vor, wenn der Ticker den
+        // Hänger vorher erkannt hat (also nur, solange loop() noch yieldete)
+        lastCrash.reason = REASON_WDT_RST;
+    }
+
+    // RTC-Inhalt verwerfen, damit er nicht beim nächsten normalen Neustart erneut gemeldet wird
+    clearContext();
+
+    Serial.println("Reset reason: " + ESP.getResetReason() + (lastCrashValid ? ", crash context available at /crash" : ""));
+
+    loopStartMs = millis();
+    watchdogTicker.attach_ms(WATCHDOG_INTERVAL, watchdogCheck);
+}
+
+void crashlogLoop()
+{
+    unsigned long now = millis();
+    if (stats.count > 0)
+    {
+        uint32_t duration = now - loopStartMs;
+        stats.totalMs += duration;
+        if (duration > stats.maxMs)
+        {
+            stats.maxMs = duration;
+        }
+    }
+    stats.count++;
+    loopStartMs = now;
+    traceEvent(TRACE_LOOP);
+
+    if (stallActive)
+    {
+        // loop() läuft wieder, ein späterer Hardware-WDT darf nicht diesen Hänger melden
+        stallActive = false;
+        clearContext();
+    }
+
+    if (!stallLogged)
+    {
+        stallLogged = true;
+        Serial.printf_P(PSTR("Loop stall detected (threshold %lu ms), trace:\n"), stallThreshold);
+        for (uint8_t i = 0; i < TRACE_SIZE; i++)
+        {
+            const TraceEntry& e = trace[(traceHead + i) & (TRACE_SIZE - 1)];
+            if (e.point != 0)
+            {
+                Serial.printf_P(PSTR("  %lu ms: %u\n"), (unsigned long)e.ms, (unsigned)e.point);
+            }
+        }
+    }
+}
+
+void traceEvent(uint8_t point)
+{
+    // aufeinanderfolgende Loop-Durchläufe nicht einzeln protokollieren
+    uint32_t last = (traceHead - 1) & (TRACE_SIZE - 1);
+    if (point == TRACE_LOOP && trace[last].point == TRACE_LOOP)
+    {
+        trace[last].ms = millis();
+        return;
+    }
+
+    trace[traceHead].ms = millis();
+    trace[traceHead].point = point;
+    traceHead = (traceHead + 1) & (TRACE_SIZE - 1);
+}
+
+uint32_t crashlogResetReason()
+{
+    return resetReason;
+}
+
+static const char* traceName(uint32_t point)
+{
+    switch (point)
+    {
+        case TRACE_LOOP:     return "loop";
+        case TRACE_HOMEE:    return "homee callback";
+        case TRACE_WEB:      return "web handler";
+        case TRACE_SCHEDULE: return "schedule";
+        case TRACE_MOVE:     return "button pulse";
+        case TRACE_STALL:    return "STALL";
+        default:             return "?";
+    }
+}
+
+static void appendStats(String& out, const LoopStats& s)
+{
+    char buf[128];
+    snprintf(buf, sizeof(buf), "loop: %lu iterations, max %lu ms, avg %lu ms, stalls %lu\n",
+             (unsigned long)s.count, (unsigned long)s.maxMs,
+             (unsigned long)(s.count > 1 ? s.totalMs / (s.count - 1) : 0), (unsigned long)s.stalls);
+    out += buf;
+}
+
+String crashlogReport()
+{
+    char buf[96];
+    String out = "reset reason: " + ESP.getResetReason() + " (" + String(resetReason) + ")\n";
+    out += "current ";
+    appendStats(out, stats);
+
+    if (!lastCrashValid)
+    {
+        out += "no crash context from previous run\n";
+        return out;
+    }
+
+    out += "\n--- previous run ---\n";
+    if (lastCrash.reason == REASON_EXCEPTION_RST || lastCrash.reason == REASON_SOFT_WDT_RST)
+    {
+        snprintf(buf, sizeof(buf), "exccause %lu, epc1 0x%08lx, excvaddr 0x%08lx\n",
+                 (unsigned long)lastCrash.exccause, (unsigned long)lastCrash.epc1, (unsigned long)lastCrash.excvaddr);
+        out += buf;
+    }
+    appendStats(out, lastCrash.stats);
+
+    out += "trace (oldest first):\n";
+    for (uint8_t i = 0; i < TRACE_SIZE; i++)
+    {
+        const TraceEntry& e = lastCrash.trace[(lastCrash.traceHead + i) & (TRACE_SIZE - 1)];
+        if (e.point != 0)
+        {
+            snprintf(buf, sizeof(buf), "  %10lu ms  %s\n", (unsigned long)e.ms, traceName(e.point));
+            out += buf;
+        }
+    }
+
+    if (lastCrash.stackWords > 0)
+    {
+        out += "stack:\n";
+        for (uint32_t i = 0; i < lastCrash.stackWords && i < STACK_WORDS; i += 4)
+        {
+            snprintf(buf, sizeof(buf), "  %08lx:", (unsigned long)(lastCrash.stackAddr + i * 4));
+            out += buf;
+            for (uint32_t j = i; j < i + 4 && j < lastCrash.stackWords; j++)
+            {
+                snprintf(buf, sizeof(buf), " %08lx", (unsigned long)lastCrash.stack[j]);
+                out += buf;
+            }
+            out += "\n";
+        }
+    }
+    return out;
+}
@@ -0,0 +1,76 @@
+#include "heapwatch.h"
+
+#ifdef UMM_STATS_FULL
+extern "C" {
+#include <umm_malloc/umm_malloc.h>
+}
+#endif
+
+static uint32_t setupCost = 0;
+static uint32_t lastFree = 0;         // freier Heap am Ende des vorigen Durchlaufs
+static uint32_t lowWater = UINT32_MAX;
+static uint32_t peakUse = 0;
+static unsigned long peakAt = 0;
+static uint32_t events = 0;
+
+void heapWatchSetupCost(uint32_t bytes)
+{
+    setupCost = bytes;
+    lastFree = 0;   // die Node bleibt belegt, nicht als Spitze dieses Durchlaufs werten
+}
+
+void heapWatchLoop()
+{
+    uint32_t freeHeap = ESP.getFreeHeap();
+#ifdef UMM_STATS_FULL
+    uint32_t minFree = umm_free_heap_size_min();
+    umm_free_heap_size_min_reset();
+#else
+    uint32_t minFree = freeHeap;
+#endif
+
+    if (lastFree == 0)
+    {
+        lastFree = freeHeap;
+    }
+
+    // Verbrauch seit dem vorigen Durchlauf: vom Stand davor bis zum Tiefststand dazwischen
+    uint32_t use = (lastFree > minFree) ? lastFree - minFree : 0;
+    lastFree = freeHeap;
+    lowWater = min(lowWater, minFree);
+
+    if (use >= HEAP_WATCH_EVENT_BYTES)
+    {
+        events++;
+    }
+    if (use > peakUse)
+    {
+        peakUse = use;
+        peakAt = millis();
+        Serial.printf_P(PSTR("Heap peak: %lu bytes used within one loop, %lu free, max block %lu\n"),
+                        (unsigned long)use, (unsigned long)minFree, (unsigned long)ESP.getMaxFreeBlockSize());
+    }
+}
+
+String heapWatchReport()
+{
+    char buf[96];
+    String out;
+    snprintf(buf, sizeof(buf), "free: %lu bytes, max block %lu, fragmentation %u%%\n",
+             (unsigned long)ESP.getFreeHeap(), (unsigned long)ESP.getMaxFreeBlockSize(), (unsigned)ESP.getHeapFragmentation());
+    out += buf;
+#ifdef UMM_STATS_FULL
+    out += "measurement: umm_malloc low water (every allocation)\n";
+#else
+    out += "measurement: sampled in loop() (build with -DUMM_STATS_FULL for peaks inside callbacks)\n";
+#endif
+    snprintf(buf, sizeof(buf), "low water: %lu bytes free\n", (unsigned long)(lowWater == UINT32_MAX ? 0 : lowWater));
+    out += buf;
+    snprintf(buf, sizeof(buf), "homee node description: %lu bytes\n", (unsigned long)setupCost);
+    out += buf;
+    snprintf(buf, sizeof(buf), "largest use within one loop: %lu bytes at %lu ms\n", (unsigned long)peakUse, (unsigned long)peakAt);
+    out += buf;
+    snprintf(buf, sizeof(buf), "loops using >= %lu bytes: %lu\n", (unsigned long)HEAP_WATCH_EVENT_BYTES, (unsigned long)events);
+    out += buf;
+    return out;
+}
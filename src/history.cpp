@@ -0,0 +1,482 @@
+#include "history.h"
+
+#include <LittleFS.h>
+#include <time.h>
+
+// Segmentdatei: Kopf + bis zu HISTORY_RECORDS_PER_SEGMENT Datensätze
+struct SegmentHeader
+{
+    uint32_t magic;
+    uint32_t seq;
+};
+
+struct SegmentInfo
+{
+    uint32_t seq;        // 0 = Segment nicht belegt
+    uint32_t firstTime;
+    uint32_t lastTime;
+    uint16_t count;
+};
+
+const uint32_t SEGMENT_MAGIC = 0x54534948; // "HIST"
+const uint32_t VALID_EPOCH = 1600000000;   // darunter ist die Uhrzeit noch nicht gesetzt
+
+static SegmentInfo segments[HISTORY_SEGMENTS];
+static uint8_t headSlot = 0;     // Segment, an das angehängt wird
+static HistoryRecord batch[HISTORY_BATCH_SIZE];
+static uint8_t batchCount = 0;
+static unsigned long batchSince = 0;
+static uint32_t batchLost = 0;   // bei vollem Puffer verworfene Einträge
+static uint32_t timeBase = 0;    // Pseudo-Zeit läuft nach einem Neustart hier weiter
+static uint32_t lastTime = 0;
+
+static String segmentPath(uint8_t slot)
+{
+    return "/hist/seg" + String(slot) + ".bin";
+}
+
+static size_t recordOffset(uint16_t record)
+{
+    return sizeof(SegmentHeader) + (size_t)record * sizeof(HistoryRecord);
+}
+
+static uint32_t readRecordTime(File& f, uint16_t record)
+{
+    HistoryRecord rec;
+    f.seek(recordOffset(record), SeekSet);
+    if (f.read((uint8_t*)&rec, sizeof(rec)) != sizeof(rec))
+    {
+        return UINT32_MAX;
+    }
+    return rec.time;
+}
+
+// Zeitstempel für neue Einträge, fällt nie (Voraussetzung für die binäre Suche)
+static uint32_t historyNow()
+{
+    time_t now = time(nullptr);
+    uint32_t t = (now > (time_t)VALID_EPOCH) ? (uint32_t)now : timeBase + (uint32_t)(micros64() / 1000000);
+    if (t < lastTime)
+    {
+        t = lastTime;
+    }
+    lastTime = t;
+    return t;
+}
+
+static void scanSegment(uint8_t slot)
+{
+    SegmentInfo& seg = segments[slot];
+    memset(&seg, 0, sizeof(seg));
+
+    String path = segmentPath(slot);
+    if (!LittleFS.exists(path))
+    {
+        return;
+    }
+
+    File f = LittleFS.open(path, "r+");
+    SegmentHeader hdr;
+    if (!f || f.read((uint8_t*)&hdr, sizeof(hdr)) != sizeof(hdr) || hdr.magic != SEGMENT_MAGIC)
+    {
+        Serial.println("History: invalid segment " + path + " removed");
+        if (f) f.close();
+        LittleFS.remove(path);
+        return;
+    }
+
+    size_t payload = f.size() - sizeof(SegmentHeader);
+    if (payload % sizeof(HistoryRecord) != 0)
+    {
+        // unvollständiger Datensatz nach Stromausfall
+        payload -= payload % sizeof(HistoryRecord);
+        f.truncate(sizeof(SegmentHeader) + payload);
+    }
+
+    seg.seq = hdr.seq;
+    seg.count = min(payload / sizeof(HistoryRecord), (size_t)HISTORY_RECORDS_PER_SEGMENT);
+    if (seg.count > 0)
+    {
+        seg.firstTime = readRecordTime(f, 0);
+        seg.lastTime = readRecordTime(f, seg.count - 1);
+    }
+    f.close();
+}
+
+// nächstes Segment im Ring anlegen, das älteste wird dabei überschrieben
+static bool rotateSegment()
+{
+    uint8_t slot = headSlot;
+    uint32_t seq = 1;
+    if (segments[headSlot].seq != 0)
+    {
+        slot = (headSlot + 1) % HISTORY_SEGMENTS;
+        seq = segments[headSlot].seq + 1;
+    }
+
+    File f = LittleFS.open(segmentPath(slot), "w");
+    if (!f)
+    {
+        Serial.println("History: cannot create segment " + segmentPath(slot));
+        return false;
+    }
+    SegmentHeader hdr = { SEGMENT_MAGIC, seq };
+    f.write((const uint8_t*)&hdr, sizeof(hdr));
+    f.close();
+
+    segments[slot].seq = seq;
+    segments[slot].count = 0;
+    segments[slot].firstTime = 0;
+    segments[slot].lastTime = 0;
+    headSlot = slot;
+    return true;
+}
+
+// belegte Segmente, ältestes zuerst; liefert die Anzahl
+static uint8_t segmentOrder(uint8_t* order)
+{
+    uint8_t n = 0;
+    for (uint8_t i = 1; i <= HISTORY_SEGMENTS; i++)
+    {
+        uint8_t slot = (headSlot + i) % HISTORY_SEGMENTS;
+        if (segments[slot].seq != 0 && segments[slot].count > 0)
+        {
+            order[n++] = slot;
+        }
+    }
+    return n;
+}
+
+static int8_t findSegment(uint32_t seq)
+{
+    for (uint8_t slot = 0; slot < HISTORY_SEGMENTS; slot++)
+    {
+        if (segments[slot].seq == seq)
+        {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+void historyBegin()
+{
+    if (!LittleFS.exists("/hist"))
+    {
+        LittleFS.mkdir("/hist");
+    }
+
+    uint32_t maxSeq = 0;
+    for (uint8_t slot = 0; slot < HISTORY_SEGMENTS; slot++)
+    {
+        scanSegment(slot);
+        if (segments[slot].seq > maxSeq)
+        {
+            maxSeq = segments[slot].seq;
+            headSlot = slot;
+        }
+    }
+
+    // das Kopfsegment kann gerade leer angelegt sein, daher über alle Segmente
+    lastTime = 0;
+    for (uint8_t slot = 0; slot < HISTORY_SEGMENTS; slot++)
+    {
+        lastTime = max(lastTime, segments[slot].lastTime);
+    }
+    timeBase = lastTime + 1;
+
+    uint32_t total = 0;
+    for (uint8_t slot = 0; slot < HISTORY_SEGMENTS; slot++)
+    {
+        total += segments[slot].count;
+    }
+    Serial.println("History: " + String(total) + " records, last time " + String(lastTime));
+}
+
+// Wird auch aus den Callbacks von ESPAsyncTCP aufgerufen, schreibt daher nie in den Flash.
+// Ist der Puffer voll, bevor historyLoop() ihn schreiben konnte, fällt der älteste Eintrag weg.
+void historyAdd(uint8_t source, uint8_t command, uint8_t result)
+{
+    if (batchCount >= HISTORY_BATCH_SIZE)
+    {
+        memmove(&batch[0], &batch[1], (HISTORY_BATCH_SIZE - 1) * sizeof(HistoryRecord));
+        batchCount--;
+        batchLost++;
+    }
+
+    HistoryRecord& rec = batch[batchCount];
+    memset(&rec, 0, sizeof(rec));
+    rec.time = historyNow();
+    rec.source = source;
+    rec.command = command;
+    rec.result = result;
+
+    if (batchCount == 0)
+    {
+        batchSince = millis();
+    }
+    batchCount++;
+}
+
+void historyFlush()
+{
+    uint8_t written = 0;
+    while (written < batchCount)
+    {
+        if (segments[headSlot].seq == 0 || segments[headSlot].count >= HISTORY_RECORDS_PER_SEGMENT)
+        {
+            if (!rotateSegment())
+            {
+                break;
+            }
+        }
+
+        SegmentInfo& seg = segments[headSlot];
+        File f = LittleFS.open(segmentPath(headSlot), "a");
+        if (!f)
+        {
+            Serial.println("History: cannot open segment " + segmentPath(headSlot));
+            break;
+        }
+
+        uint16_t n = min((uint16_t)(batchCount - written), (uint16_t)(HISTORY_RECORDS_PER_SEGMENT - seg.count));
+        f.write((const uint8_t*)&batch[written], n * sizeof(HistoryRecord));
+        f.close();
+
+        if (seg.count == 0)
+        {
+            seg.firstTime = batch[written].time;
+        }
+        seg.count += n;
+        seg.lastTime = batch[written + n - 1].time;
+        written += n;
+    }
+
+    // bei Fehler wird der Block verworfen, sonst liefe der Puffer voll
+    batchCount = 0;
+
+    if (batchLost > 0)
+    {
+        Serial.println("History: " + String(batchLost) + " records lost, buffer was full");
+        batchLost = 0;
+    }
+}
+
+void historyLoop()
+{
+    if (batchCount >= HISTORY_FLUSH_THRESHOLD || (batchCount > 0 && (millis() - batchSince >= HISTORY_FLUSH_INTERVAL)))
+    {
+        historyFlush();
+    }
+}
+
+// Position eines Cursors im noch nicht geschriebenen Puffer, -1 = Position liegt im Flash.
+// batch[k] landet beim nächsten historyFlush() genau an dieser Position, ein Cursor bleibt
+// dadurch auch über das Schreiben hinweg gültig.
+static int16_t batchIndex(const HistoryCursor& cursor)
+{
+    const SegmentInfo& head = segments[headSlot];
+    if (head.seq != 0 && cursor.segmentSeq == head.seq)
+    {
+        return (cursor.record >= head.count) ? (int16_t)(cursor.record - head.count) : -1;
+    }
+    if (cursor.segmentSeq == head.seq + 1)
+    {
+        uint16_t room = (head.seq == 0) ? 0 : HISTORY_RECORDS_PER_SEGMENT - head.count;
+        return (int16_t)(room + cursor.record);
+    }
+    return -1;
+}
+
+// Cursor auf batch[k] setzen (Umkehrung von batchIndex)
+static void batchPosition(uint8_t k, HistoryCursor& cursor)
+{
+    const SegmentInfo& head = segments[headSlot];
+    uint16_t room = (head.seq == 0) ? 0 : HISTORY_RECORDS_PER_SEGMENT - head.count;
+    if (k < room)
+    {
+        cursor.segmentSeq = head.seq;
+        cursor.record = head.count + k;
+    }
+    else
+    {
+        cursor.segmentSeq = head.seq + 1;
+        cursor.record = k - room;
+    }
+}
+
+// Wird aus dem Webserver-Callback aufgerufen, liest daher nur; noch nicht geschriebene
+// Einträge liefert historyRead() direkt aus dem Puffer.
+void historyQuery(uint32_t from, uint32_t to, HistoryCursor& cursor)
+{
+    cursor.to = to;
+    cursor.done = true;
+
+    uint8_t order[HISTORY_SEGMENTS];
+    uint8_t n = segmentOrder(order);
+
+    // erstes Segment mit lastTime >= from
+    uint8_t lo = 0, hi = n;
+    while (lo < hi)
+    {
+        uint8_t mid = (lo + hi) / 2;
+        if (segments[order[mid]].lastTime < from)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    if (lo == n)
+    {
+        // alle geschriebenen Einträge sind älter, im Puffer weitersuchen
+        for (uint8_t k = 0; k < batchCount; k++)
+        {
+            if (batch[k].time >= from)
+            {
+                batchPosition(k, cursor);
+                cursor.done = false;
+                break;
+            }
+        }
+        return;
+    }
+
+    uint8_t slot = order[lo];
+    File f = LittleFS.open(segmentPath(slot), "r");
+    if (!f)
+    {
+        return;
+    }
+
+    // erster Datensatz im Segment mit time >= from
+    uint16_t rlo = 0, rhi = segments[slot].count;
+    while (rlo < rhi)
+    {
+        uint16_t mid = (rlo + rhi) / 2;
+        if (readRecordTime(f, mid) < from)
+        {
+            rlo = mid + 1;
+        }
+        else
+        {
+            rhi = mid;
+        }
+    }
+    f.close();
+
+    cursor.segmentSeq = segments[slot].seq;
+    cursor.record = rlo;
+    cursor.done = false;
+}
+
+size_t historyRead(HistoryCursor& cursor, HistoryRecord* records, size_t maxRecords)
+{
+    size_t n = 0;
+    while (!cursor.done && n < maxRecords)
+    {
+        if (cursor.record >= HISTORY_RECORDS_PER_SEGMENT)
+        {
+            cursor.segmentSeq++;
+            cursor.record = 0;
+        }
+
+        int16_t k = batchIndex(cursor);
+        if (k >= 0)
+        {
+            if (k >= batchCount || batch[k].time > cursor.to)
+            {
+                cursor.done = true;
+                break;
+            }
+            records[n++] = batch[k];
+            cursor.record++;
+            continue;
+        }
+
+        int8_t slot = findSegment(cursor.segmentSeq);
+        if (slot < 0)
+        {
+            // Segment wurde inzwischen überschrieben, beim ältesten noch vorhandenen weitermachen
+            uint8_t order[HISTORY_SEGMENTS];
+            uint8_t count = segmentOrder(order);
+            if (count == 0 || segments[order[0]].seq < cursor.segmentSeq)
+            {
+                cursor.done = true;
+                break;
+            }
+            cursor.segmentSeq = segments[order[0]].seq;
+            cursor.record = 0;
+            continue;
+        }
+
+        SegmentInfo& seg = segments[slot];
+        if (cursor.record >= seg.count)
+        {
+            cursor.segmentSeq++;
+            cursor.record = 0;
+            continue;
+        }
+
+        File f = LittleFS.open(segmentPath(slot), "r");
+        if (!f)
+        {
+            cursor.done = true;
+            break;
+        }
+        f.seek(recordOffset(cursor.record), SeekSet);
+        while (n < maxRecords && cursor.record < seg.count)
+        {
+            HistoryRecord& rec = records[n];
+            if (f.read((uint8_t*)&rec, sizeof(rec)) != sizeof(rec))
+            {
+                cursor.done = true;
+                break;
+            }
+            if (rec.time > cursor.to)
+            {
+                cursor.done = true;
+                break;
+            }
+            cursor.record++;
+            n++;
+        }
+        f.close();
+    }
+    return n;
+}
+
+const char* historySourceName(uint8_t source)
+{
+    switch (source)
+    {
+        case HIST_SRC_HOMEE:    return "homee";
+        case HIST_SRC_SCHEDULE: return "schedule";
+        case HIST_SRC_SYSTEM:   return "system";
+        default:                return "unknown";
+    }
+}
+
+const char* historyCommandName(uint8_t command)
+{
+    switch (command)
+    {
+        case 0:  return "up";
+        case 1:  return "down";
+        case 2:  return "stop";
+        default: return "unknown";
+    }
+}
+
+const char* historyResultName(uint8_t result)
+{
+    switch (result)
+    {
+        case HIST_RES_EXECUTED: return "executed";
+        case HIST_RES_REJECTED: return "rejected";
+        case HIST_RES_DROPPED:  return "dropped";
+        default:                return "unknown";
+    }
+}
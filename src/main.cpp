@@ -5,9 +5,16 @@
 #include <ArduinoOTA.h>
 #include <EEPROM.h>
 #include <LittleFS.h>
-#include <DNSServer.h>
+#include <WiFiUdp.h>
 
 #include "virtualHomee.hpp"
+#include "history.h"
+#include "scheduler.h"
+#include "crashlog.h"
+#include "pulse.h"
+#include "captivedns.h"
+#include "control.h"
+#include "heapwatch.h"
 
 // Version und Konstanten
 const double FIRMWARE_VERSION_d = 2.01;
@@ -21,21 +28,34 @@ const uint8_t PIN_STOP = 12;
 const uint8_t PIN_DOWN = 13;
 const uint8_t PIN_LED = 16; 
 
+// Tastendruck: Pulsbreite und Mindestpause zwischen zwei Pulsen
+// Pulsbreite per Build-Flag einstellbar, z.B. -DPULSE_WIDTH_MS=200 (siehe env:esp12e_pulse_benchmark)
+#ifndef PULSE_WIDTH_MS
+#define PULSE_WIDTH_MS 500
+#endif
+const uint32_t pulseWidthUs = PULSE_WIDTH_MS * 1000UL;
+const unsigned long pulseGapMs = 200;
+
 // homee Attribute IDs
 const uint32_t ID_SHUTTER = 1;
 const uint32_t ID_DISABLE = 2;
 const uint32_t ID_SW_VER = 3;
+const uint32_t ID_RESET_REASON = 4;
+
 
 // Access Point Konfiguration (fest)
 const char* const AP_SSID = "VELUX Control";
 const char* const AP_PASSWORD = "12345678";
 const IPAddress AP_IP(192, 168, 4, 1);
 const IPAddress AP_SUBNET(255, 255, 255, 0);
+const uint16_t DNS_PORT = 53;
+const uint8_t DNS_PACKETS_PER_LOOP = 4; // höchstens so viele DNS-Anfragen je loop()-Durchlauf
 
 // EEPROM Layout
 const uint16_t EEPROM_SIZE = 512;
 const uint8_t EEPROM_MAGIC_BYTE = 0x42;
 const uint16_t EEPROM_CFG_ADDR = 0;
+const uint16_t EEPROM_SCHED_ADDR = 256; // Zeitsteuerung, eigenes Prüfbyte
 
 // Konfigurationsstruktur
 struct ConfigData 
@@ -50,19 +70,20 @@ struct ConfigData
     uint8_t checkValue;
 };
 
+static_assert(sizeof(ConfigData) <= EEPROM_SCHED_ADDR, "ConfigData overlaps schedule");
+static_assert(EEPROM_SCHED_ADDR + sizeof(ScheduleConfig) <= EEPROM_SIZE, "ScheduleConfig exceeds EEPROM");
+
 // Globale Variablen
 ConfigData config;
 bool isConfigMode = false;
 AsyncWebServer server(80);
-DNSServer dnsServer;
+WiFiUDP dnsUdp;
 virtualHomee vhih;
-unsigned long lastWifiCheckTime = 0;
-const unsigned long wifiCheckInterval = 30000; // Alle 30 Sekunden WLAN prüfen
+const unsigned long loopStallThreshold = 1000; // loop() länger blockiert gilt als Hänger
 bool wifiConnected = false;
 unsigned long lastBlinkTime = 0;
 const unsigned long blinkInterval = 500; // 500ms Blink-Intervall
 bool ledState = false;
-bool shutterDisabled = false;
 
 // Funktionsprototypen
 void setupConfigurationMode();
@@ -71,18 +92,43 @@ void handleRoot(AsyncWebServerRequest *request);
 void handleSave(AsyncWebServerRequest *request);
 void handleRestart(AsyncWebServerRequest *request);
 void handleNotFound(AsyncWebServerRequest *request);
+void handleHistory(AsyncWebServerRequest *request);
+void handleCrash(AsyncWebServerRequest *request);
+void handleCaptivePortal(AsyncWebServerRequest *request);
+void handlePulse(AsyncWebServerRequest *request);
+void handleHeap(AsyncWebServerRequest *request);
 void moveUp();
 void moveDown();
 void moveStop();
 bool saveConfiguration();
 bool loadConfiguration();
-void IRAM_ATTR callBack_homeeReceiveValue(nodeAttributes* attr);
+void callBack_homeeReceiveValue(nodeAttributes* attr);
+void callBack_scheduleFired(uint8_t command);
 void ledOn();
 void ledOff();
 void ledToggle();
 void ledBlink();
 String loadAndProcessHTML(const String& filename);
 String replaceVariables(String html);
+String scheduleRowsHTML();
+void deferAction(AsyncWebServerRequest *request, uint8_t actions);
+void runDeferredActions();
+void captiveDnsLoop();
+
+// Verzögerte Aktionen aus den Webserver-Callbacks
+// Die Handler laufen im Kontext von ESPAsyncTCP, dort darf weder delay() noch ein Neustart
+// ausgeführt werden, sonst wird die Antwort nicht mehr fertig gesendet. Die Handler merken
+// sich die Aktion nur vor, loop() führt sie aus, sobald der Client die Verbindung geschlossen hat.
+enum DeferredAction : uint8_t
+{
+    ACTION_COMMIT_CONFIG = 0x01,  // Konfiguration ins EEPROM schreiben
+    ACTION_RESTART       = 0x02   // ESP neu starten
+};
+
+static volatile uint8_t deferredActions = 0;
+static volatile bool deferredClientGone = true;
+static unsigned long deferredSince = 0;
+const unsigned long deferredActionTimeout = 3000; // spätestens dann ausführen, auch ohne Disconnect
 
 // HTML-Template-Verarbeitung
 String loadAndProcessHTML(const String& filename) {
@@ -137,7 +183,59 @@ String replaceVariables(String html) {
     // Homee-Konfiguration
     html.replace("{{HOMEE_NAME}}", String(config.homee_name));
     html.replace("{{HOMEE_ID}}", String(config.homee_id));
+
+    // Zeitsteuerung
+    html.replace("{{LATITUDE}}", String(scheduleConfig.latitude, 4));
+    html.replace("{{LONGITUDE}}", String(scheduleConfig.longitude, 4));
+    html.replace("{{TIMEZONE}}", String(scheduleConfig.timezone));
+    html.replace("{{NTP_SERVER}}", String(scheduleConfig.ntp_server));
+    if (html.indexOf("{{SCHEDULE_ROWS}}") >= 0) {
+        html.replace("{{SCHEDULE_ROWS}}", scheduleRowsHTML());
+    }
+    
+    return html;
+}
+
+static String htmlOption(int value, const char* label, bool selected) {
+    return "<option value='" + String(value) + "'" + (selected ? " selected" : "") + ">" + label + "</option>";
+}
+
+// Tabellenzeilen der Zeitsteuerung, eine je Eintrag
+String scheduleRowsHTML() {
+    static const char* const dayNames[7] = { "So", "Mo", "Di", "Mi", "Do", "Fr", "Sa" };
+    String html;
     
+    for (uint8_t i = 0; i < SCHEDULE_ENTRIES; i++) {
+        const ScheduleEntry& e = scheduleConfig.entries[i];
+        String p = "s" + String(i) + "_";
+        bool sun = (e.type == SCHED_SUNRISE || e.type == SCHED_SUNSET);
+        
+        char timeStr[6] = "";
+        if (e.type == SCHED_FIXED) {
+            snprintf(timeStr, sizeof(timeStr), "%02d:%02d", e.minutes / 60, e.minutes % 60);
+        }
+        
+        html += "<tr><td><select name='" + p + "type'>";
+        html += htmlOption(SCHED_OFF, "aus", e.type == SCHED_OFF);
+        html += htmlOption(SCHED_FIXED, "Uhrzeit", e.type == SCHED_FIXED);
+        html += htmlOption(SCHED_SUNRISE, "Sonnenaufgang", e.type == SCHED_SUNRISE);
+        html += htmlOption(SCHED_SUNSET, "Sonnenuntergang", e.type == SCHED_SUNSET);
+        html += "</select></td>";
+        html += "<td><input type='time' name='" + p + "time' value='" + String(timeStr) + "'></td>";
+        html += "<td><input type='number' name='" + p + "offset' min='-720' max='720' value='" + String(sun ? e.minutes : 0) + "'></td>";
+        html += "<td><select name='" + p + "cmd'>";
+        html += htmlOption(CMD_UP, "hoch", e.command == CMD_UP);
+        html += htmlOption(CMD_DOWN, "runter", e.command == CMD_DOWN);
+        html += htmlOption(CMD_STOP, "stop", e.command == CMD_STOP);
+        html += "</select></td><td>";
+        for (uint8_t d = 0; d < 7; d++) {
+            // Montag zuerst anzeigen
+            uint8_t wd = (d + 1) % 7;
+            html += "<label class='day'><input type='checkbox' name='" + p + "wd" + String(wd) + "'" +
+                    ((e.weekdays & (1 << wd)) ? " checked" : "") + ">" + dayNames[wd] + "</label>";
+        }
+        html += "</td></tr>";
+    }
     return html;
 }
 
@@ -149,6 +247,7 @@ bool saveConfiguration() {
     
     // Write the complete configuration at once
     EEPROM.put(EEPROM_CFG_ADDR, config);
+    scheduleStoreConfig(EEPROM_SCHED_ADDR);
     
     // Commit the changes and check result
     bool success = EEPROM.commit();
@@ -209,11 +308,13 @@ bool loadConfiguration()
 }
 
 void handleRoot(AsyncWebServerRequest *request) {
+    traceEvent(TRACE_WEB);
     String html = loadAndProcessHTML("/config.html");
     request->send(200, "text/html", html);
 }
 
 void handleSave(AsyncWebServerRequest *request) {
+    traceEvent(TRACE_WEB);
     bool paramsFound = false;
     
     if (request->hasParam("ssid", true)) {
@@ -282,42 +383,83 @@ void handleSave(AsyncWebServerRequest *request) {
         }
         paramsFound = true;
     }
-    
-    // Nur speichern, wenn auch Parameter gefunden wurden
-    bool saved = false;
-    if (paramsFound) {
-        saved = saveConfiguration();
-        Serial.println("Parameters found and configuration saved");
-    } else {
-        Serial.println("No parameters found! Configuration NOT saved");
+
+    // Zeitsteuerung
+    if (request->hasParam("latitude", true) && request->hasParam("longitude", true)) {
+        scheduleConfig.latitude = constrain(request->getParam("latitude", true)->value().toFloat(), -90.0f, 90.0f);
+        scheduleConfig.longitude = constrain(request->getParam("longitude", true)->value().toFloat(), -180.0f, 180.0f);
+        paramsFound = true;
+    }
+
+    if (request->hasParam("timezone", true)) {
+        request->getParam("timezone", true)->value().toCharArray(scheduleConfig.timezone, sizeof(scheduleConfig.timezone));
+        paramsFound = true;
+    }
+
+    if (request->hasParam("ntp_server", true)) {
+        request->getParam("ntp_server", true)->value().toCharArray(scheduleConfig.ntp_server, sizeof(scheduleConfig.ntp_server));
+        paramsFound = true;
+    }
+
+    for (uint8_t i = 0; i < SCHEDULE_ENTRIES; i++) {
+        String p = "s" + String(i) + "_";
+        if (!request->hasParam(p + "type", true)) {
+            continue;
+        }
+        
+        ScheduleEntry& e = scheduleConfig.entries[i];
+        e.type = constrain(request->getParam(p + "type", true)->value().toInt(), SCHED_OFF, SCHED_SUNSET);
+        e.command = request->hasParam(p + "cmd", true) ? constrain(request->getParam(p + "cmd", true)->value().toInt(), CMD_UP, CMD_STOP) : CMD_STOP;
+        e.minutes = 0;
+        if (e.type == SCHED_FIXED && request->hasParam(p + "time", true)) {
+            // Format HH:MM
+            String t = request->getParam(p + "time", true)->value();
+            e.minutes = constrain(t.substring(0, 2).toInt(), 0, 23) * 60 + constrain(t.substring(3, 5).toInt(), 0, 59);
+        } else if (e.type != SCHED_FIXED && request->hasParam(p + "offset", true)) {
+            e.minutes = constrain(request->getParam(p + "offset", true)->value().toInt(), -720, 720);
+        }
+        
+        // nicht angehakte Checkboxen werden nicht übertragen
+        e.weekdays = 0;
+        for (uint8_t d = 0; d < 7; d++) {
+            if (request->hasParam(p + "wd" + String(d), true)) {
+                e.weekdays |= (1 << d);
+            }
+        }
+        paramsFound = true;
     }
     
     // HTML-Template laden und Variablen ersetzen
     String html = loadAndProcessHTML("/save_response.html");
     
-    if (saved) {
+    if (paramsFound) {
         html.replace("{{STATUS_CLASS}}", "success");
-        html.replace("{{MESSAGE}}", "Parameter successfully stored. The device will be restarted soon.");
+        html.replace("{{MESSAGE}}", "Parameters received. They will be stored and the device will restart. If this page is still reachable afterwards, saving failed (see serial monitor).");
     } else {
         html.replace("{{STATUS_CLASS}}", "error");
-        html.replace("{{MESSAGE}}", "No changed values found or storing failed.");
+        html.replace("{{MESSAGE}}", "No changed values found.");
     }
     
     request->send(200, "text/html", html);
     
-    // Verzögerter Neustart nach dem Senden der Antwort
-    delay(1000);
-    if (paramsFound) ESP.restart();
+    // Nur speichern, wenn auch Parameter gefunden wurden. Speichern und Neustart erst,
+    // nachdem die Antwort beim Client angekommen ist (siehe runDeferredActions)
+    if (paramsFound) {
+        Serial.println("Parameters found, configuration will be saved");
+        deferAction(request, ACTION_COMMIT_CONFIG | ACTION_RESTART);
+    } else {
+        Serial.println("No parameters found! Configuration NOT saved");
+    }
 }
 
 void handleRestart(AsyncWebServerRequest *request) 
 {
+    traceEvent(TRACE_WEB);
     String html = loadAndProcessHTML("/restart.html");
     request->send(200, "text/html", html);
     
     // Nach dem Senden neu starten
-    delay(1000);
-    ESP.restart();
+    deferAction(request, ACTION_RESTART);
 }
 
 void handleNotFound(AsyncWebServerRequest *request) 
@@ -325,6 +467,167 @@ void handleNotFound(AsyncWebServerRequest *request)
     request->send(404, "text/plain", "Seite nicht gefunden");
 }
 
+// Ereignis-Historie als CSV: /history?from=<unix>&to=<unix>
+// Die Datensätze werden blockweise aus LittleFS gelesen und direkt in den Chunk-Puffer
+// geschrieben, das Log wird nie komplett in den RAM geladen.
+void handleHistory(AsyncWebServerRequest *request)
+{
+    traceEvent(TRACE_WEB);
+    uint32_t from = 0;
+    uint32_t to = UINT32_MAX;
+    if (request->hasParam("from")) {
+        from = strtoul(request->getParam("from")->value().c_str(), nullptr, 10);
+    }
+    if (request->hasParam("to")) {
+        to = strtoul(request->getParam("to")->value().c_str(), nullptr, 10);
+    }
+
+    std::shared_ptr<HistoryCursor> cursor = std::make_shared<HistoryCursor>();
+    historyQuery(from, to, *cursor);
+
+    AsyncWebServerResponse *response = request->beginChunkedResponse("text/csv", 
+        [cursor](uint8_t *buffer, size_t maxLen, size_t index) -> size_t 
+        {
+            const char* const header = "time,source,command,result\n";
+            const size_t maxLineLen = 40; // "4294967295,schedule,unknown,executed\n" + NUL
+            char* out = (char*)buffer;
+            size_t len = 0;
+
+            // passt nicht einmal eine Zeile, später mit mehr Platz erneut fragen;
+            // 0 würde die Antwort beenden
+            if (index == 0) {
+                size_t headerLen = strlen(header);
+                if (headerLen >= maxLen) {
+                    return RESPONSE_TRY_AGAIN;
+                }
+                memcpy(out, header, headerLen);
+                len = headerLen;
+            }
+
+            HistoryRecord records[8];
+            while (!cursor->done && (maxLen - len) >= maxLineLen) {
+                size_t fit = min((maxLen - len) / maxLineLen, (size_t)8);
+                size_t n = historyRead(*cursor, records, fit);
+                for (size_t i = 0; i < n; i++) {
+                    int written = snprintf(out + len, maxLen - len, "%lu,%s,%s,%s\n", (unsigned long)records[i].time,
+                                           historySourceName(records[i].source),
+                                           historyCommandName(records[i].command),
+                                           historyResultName(records[i].result));
+                    len += min((size_t)max(written, 0), maxLen - len - 1);
+                }
+            }
+
+            if (len == 0 && !cursor->done) {
+                return RESPONSE_TRY_AGAIN;
+            }
+            return len;
+        });
+    request->send(response);
+}
+
+// Captive Portal: Verbindungstests der Betriebssysteme (Android generate_204, Apple
+// hotspot-detect, Windows connecttest/ncsi, Firefox canonical) und alle unbekannten Seiten
+// werden auf die Konfigurationsseite umgeleitet. Das Gerät erkennt daraufhin ein Portal und
+// öffnet die Seite selbst, statt das WLAN wegen "kein Internet" zu trennen.
+void handleCaptivePortal(AsyncWebServerRequest *request)
+{
+    request->redirect("http://" + AP_IP.toString() + "/");
+}
+
+// Wartende DNS-Anfragen beantworten, begrenzt je Durchlauf und ohne zu blockieren
+void captiveDnsLoop()
+{
+    static uint8_t packet[CAPTIVE_DNS_MAX_PACKET];
+    static uint8_t reply[CAPTIVE_DNS_MAX_PACKET];
+    const uint8_t ip[4] = { AP_IP[0], AP_IP[1], AP_IP[2], AP_IP[3] };
+
+    for (uint8_t i = 0; i < DNS_PACKETS_PER_LOOP; i++)
+    {
+        int size = dnsUdp.parsePacket();
+        if (size <= 0)
+        {
+            return;
+        }
+        if (size > (int)sizeof(packet))
+        {
+            dnsUdp.flush(); // zu groß für eine gewöhnliche Anfrage, verwerfen
+            continue;
+        }
+
+        dnsUdp.read(packet, size);
+        size_t len = captiveDnsReply(packet, size, reply, sizeof(reply), ip);
+        if (len > 0)
+        {
+            dnsUdp.beginPacket(dnsUdp.remoteIP(), dnsUdp.remotePort());
+            dnsUdp.write(reply, len);
+            dnsUdp.endPacket();
+        }
+    }
+}
+
+// Statistik der gemessenen Pulsbreiten
+void handlePulse(AsyncWebServerRequest *request)
+{
+    traceEvent(TRACE_WEB);
+    request->send(200, "text/plain", pulseReport());
+}
+
+// Heap-Verbrauch der homee-Anbindung
+void handleHeap(AsyncWebServerRequest *request)
+{
+    traceEvent(TRACE_WEB);
+    request->send(200, "text/plain", heapWatchReport());
+}
+
+// Reset-Grund und Absturzkontext des letzten Laufs
+void handleCrash(AsyncWebServerRequest *request)
+{
+    traceEvent(TRACE_WEB);
+    request->send(200, "text/plain", crashlogReport());
+}
+
+void deferAction(AsyncWebServerRequest *request, uint8_t actions)
+{
+    deferredActions |= actions;
+    deferredSince = millis();
+    deferredClientGone = false;
+    request->onDisconnect([]() 
+    {
+        deferredClientGone = true;
+    });
+}
+
+void runDeferredActions()
+{
+    if (deferredActions == 0)
+    {
+        return;
+    }
+
+    // warten, bis die Antwort gesendet und die Verbindung geschlossen ist
+    if (!deferredClientGone && (millis() - deferredSince < deferredActionTimeout))
+    {
+        return;
+    }
+
+    uint8_t actions = deferredActions;
+    deferredActions = 0;
+
+    if ((actions & ACTION_COMMIT_CONFIG) && !saveConfiguration())
+    {
+        // mit alter Konfiguration neu zu starten hilft nicht, im aktuellen Modus bleiben
+        Serial.println("Saving configuration failed, restart skipped");
+        return;
+    }
+
+    if (actions & ACTION_RESTART)
+    {
+        Serial.println("Restarting ESP8266...");
+        historyFlush();
+        ESP.restart();
+    }
+}
+
 void setupConfigurationMode() 
 {
     Serial.println("Starting configuration mode, connect to AP:");
@@ -348,6 +651,7 @@ void setupConfigurationMode()
     server.on("/", HTTP_GET, handleRoot);
     server.on("/save", HTTP_POST, handleSave);
     server.on("/restart", HTTP_GET, handleRestart);
+    server.on("/crash", HTTP_GET, handleCrash);
     
     // Update-Handler einrichten
     server.on("/update", HTTP_POST, [](AsyncWebServerRequest *request) {
@@ -360,8 +664,7 @@ void setupConfigurationMode()
         response->addHeader("Connection", "close");
         request->send(response);
         if (shouldReboot) {
-            delay(1000);
-            ESP.restart();
+            deferAction(request, ACTION_RESTART);
         }
     }, [](AsyncWebServerRequest *request, String filename, size_t index, uint8_t *data, size_t len, bool final) {
         if (!index) {
@@ -397,7 +700,20 @@ void setupConfigurationMode()
         }
     });
     
-    server.onNotFound(handleNotFound);
+    // Captive Portal
+    server.on("/generate_204", HTTP_ANY, handleCaptivePortal);
+    server.on("/gen_204", HTTP_ANY, handleCaptivePortal);
+    server.on("/hotspot-detect.html", HTTP_ANY, handleCaptivePortal);
+    server.on("/library/test/success.html", HTTP_ANY, handleCaptivePortal);
+    server.on("/connecttest.txt", HTTP_ANY, handleCaptivePortal);
+    server.on("/ncsi.txt", HTTP_ANY, handleCaptivePortal);
+    server.on("/redirect", HTTP_ANY, handleCaptivePortal);
+    server.on("/canonical.html", HTTP_ANY, handleCaptivePortal);
+    server.on("/success.txt", HTTP_ANY, handleCaptivePortal);
+    server.onNotFound(handleCaptivePortal);
+
+    // DNS beantwortet jede Anfrage mit der eigenen IP (siehe captiveDnsLoop)
+    dnsUdp.begin(DNS_PORT);
     
     // OTA-Update einrichten
     ArduinoOTA.setHostname("velux-rolladen");
@@ -456,50 +772,43 @@ void setupConfigurationMode()
 }
 
 // Rolladen-Steuerungsfunktionen
+// Der Puls läuft per timer1 im Hintergrund (siehe pulse.cpp), die LED wird in loop()
+// ausgeschaltet, sobald der Puls beendet ist.
 void moveUp() 
 {   
     Serial.println("Moving up...");
+    traceEvent(TRACE_MOVE);
     ledOn(); //simulated button pressing started
-    pinMode(PIN_UP, OUTPUT_OPEN_DRAIN);  //not sure if OPEN_DRAIN works, so configure pin as output only temporarily
-    digitalWrite(PIN_UP, LOW);
-    delay(500);
-    digitalWrite(PIN_UP, HIGH);
-    pinMode(PIN_UP, INPUT);
-    ledOff(); //simulated button press finished
+    pulseStart(PIN_UP, pulseWidthUs);
 }
 
 void moveDown() 
 {
     Serial.println("Moving down...");
+    traceEvent(TRACE_MOVE);
     ledOn(); //simulated button pressing started
-    pinMode(PIN_DOWN, OUTPUT_OPEN_DRAIN);  //not sure if OPEN_DRAIN works, so configure pin as output only temporarily
-    digitalWrite(PIN_DOWN, LOW);
-    delay(500);
-    digitalWrite(PIN_DOWN, HIGH);
-    pinMode(PIN_DOWN, INPUT);
-    ledOff(); //simulated button press finished
+    pulseStart(PIN_DOWN, pulseWidthUs);
 }
 
 void moveStop() 
 {
     Serial.println("Stopping...");
+    traceEvent(TRACE_MOVE);
     ledOn(); //simulated button pressing started
-    pinMode(PIN_STOP, OUTPUT_OPEN_DRAIN);  //not sure if OPEN_DRAIN works, so configure pin as output only temporarily
-    digitalWrite(PIN_STOP, LOW);
-    delay(500);
-    digitalWrite(PIN_STOP, HIGH);
-    pinMode(PIN_STOP, INPUT);
-    ledOff(); //simulated button press finished
+    pulseStart(PIN_STOP, pulseWidthUs);
 }
 
 // Homee-Callback-Funktion
-static bool mvUp=false, mvDown=false, mvStop=false;
-
-void IRAM_ATTR callBack_homeeReceiveValue(nodeAttributes* attr)
+// Wird aus dem Kontext von ESPAsyncTCP aufgerufen, nicht aus einer ISR. IRAM_ATTR bringt hier
+// nichts (Serial, String und vhih liegen ohnehin im Flash) und kostet nur knappes IRAM, das der
+// WiFi-Stack braucht. Der Callback legt den Befehl nur in die Warteschlange, die Ausführung
+// erfolgt in loop(). Texte liegen per PSTR im Flash statt als temporäre Strings im Heap.
+void callBack_homeeReceiveValue(nodeAttributes* attr)
 {
+    traceEvent(TRACE_HOMEE);
     if (attr == nullptr) 
     {
-        Serial.println("Error: attr is null");
+        Serial.println(F("Error: attr is null"));
         return;
     }
 
@@ -508,52 +817,43 @@ void IRAM_ATTR callBack_homeeReceiveValue(nodeAttributes* attr)
     uint32_t id = attr->getId();
     double_t value = attr->getCurrentValue();
 
-    Serial.println("Received value: " + String(value) + " for ID: " + String(id));
+    Serial.printf_P(PSTR("Received value: %.2f for ID: %u\n"), value, id);
     
     // Je nach empfangener Nachricht die entsprechende Aktion ausführen
     if (id == ID_DISABLE)
     {
-        if (value == 0)
-        {
-            shutterDisabled = false;
-            Serial.println("Shutter enabled");
-        }
-        else
-        {
-            shutterDisabled = true;
-            Serial.println("Shutter disabled");
-        }
+        controlSetDisabled(value != 0);
+        Serial.println(value != 0 ? F("Shutter disabled") : F("Shutter enabled"));
         return;
     }
 
     if (id != ID_SHUTTER) 
     {
-        Serial.println("Unknown ID received: " + String(id));   
+        Serial.printf_P(PSTR("Unknown ID received: %u\n"), id);
         return;
     }
 
-    switch((uint8_t)value)
+    uint8_t cmd = (uint8_t)value;
+    if (cmd > CMD_STOP)
     {
-        case 0:
-            if (!shutterDisabled) mvUp = true; 
-            break;
-        case 1:
-            if (!shutterDisabled) mvDown = true;
-            break;
-        case 2:
-            mvStop = true;  //Stop will also work if Shutter is disabled
-            break;
-        default:
-            Serial.println("Unknown value received: " + String(value));   
-            return;
+        Serial.printf_P(PSTR("Unknown value received: %.2f\n"), value);
+        return;
     }
-}
 
+    controlSubmit(cmd, HIST_SRC_HOMEE);
+}
 
+// Zeitsteuerung: gleicher Weg wie ein Befehl von homee
+void callBack_scheduleFired(uint8_t command)
+{
+    traceEvent(TRACE_SCHEDULE);
+    controlSubmit(command, HIST_SRC_SCHEDULE);
+}
 
 void setupHomee() 
 {
     Serial.println("Setting up homee (ID " + String(config.homee_id) + " - " + config.homee_name + ")");
+    uint32_t heapBefore = ESP.getFreeHeap();
     
     //config.homee_name
     node* n1 = new node(config.homee_id, 2002, config.homee_name); // 2002 = Rolladensteuerung
@@ -585,30 +885,30 @@ void setupHomee()
     attr->setCallback(nullptr);
     n1->AddAttributes(attr);
 
+    // Attribut: Reset-Grund des letzten Neustarts (REASON_*, 0 = Einschalten, 1 = WDT,
+    // 2 = Exception, 3 = Soft-WDT, 4 = Neustart, 6 = Reset-Pin); Details unter /crash
+    attr = new nodeAttributes(0, ID_RESET_REASON);  // allgemeiner Zahlenwert
+    attr->setName("Reset reason");
+    attr->setUnit("");
+    attr->setCurrentValue(crashlogResetReason());
+    attr->setEditable(false);
+    attr->setCallback(nullptr);
+    n1->AddAttributes(attr);
+
     // Node zur homee hinzufügen
     vhih.addNode(n1);
     
     // homee starten
     vhih.start();
 
-
+    heapWatchSetupCost(heapBefore - ESP.getFreeHeap());
     Serial.println("Homee configured");
 }
 
 
-void setupControlMode() 
+// Anbindung der Ablaufsteuerung (control.h) an WLAN, Pulse und LED
+static void wifiBegin()
 {
-    Serial.println("Starting control mode");
-    isConfigMode = false;
-    
-    // configure pins as INPUTS so nothing happens if somebody presses keys manually
-    pinMode(PIN_UP, INPUT);
-    pinMode(PIN_DOWN, INPUT);
-    pinMode(PIN_STOP, INPUT);
-    
-    // WLAN-Verbindung herstellen
-    WiFi.mode(WIFI_STA);
-
     IPAddress gateway(config.gateway_ip[0], config.gateway_ip[1], config.gateway_ip[2], config.gateway_ip[3]);
     IPAddress client(config.client_ip[0], config.client_ip[1], config.client_ip[2], config.client_ip[3]);
     IPAddress subnet(config.subnet_mask[0], config.subnet_mask[1], config.subnet_mask[2], config.subnet_mask[3]);
@@ -620,40 +920,74 @@ void setupControlMode()
     Serial.println("    Client IP: " + client.toString());
     Serial.println("  Subnet Mask: " + subnet.toString());
     Serial.println("");
-    Serial.print("Connecting ");
-    
 
     WiFi.config(client, gateway, subnet);
     WiFi.begin(config.wifi_ssid, config.wifi_password);
-    
-    int attempts = 0;
-    while (WiFi.status() != WL_CONNECTED && attempts < 20) 
+}
+
+// erste WLAN-Verbindung nach dem Start
+static void goOnline()
+{
+    // Homee einrichten
+    setupHomee();
+
+    // Webserver für Abfragen im Betrieb (homee nutzt einen eigenen Port)
+    server.on("/history", HTTP_GET, handleHistory);
+    server.on("/crash", HTTP_GET, handleCrash);
+    server.on("/pulse", HTTP_GET, handlePulse);
+    server.on("/heap", HTTP_GET, handleHeap);
+    server.onNotFound(handleNotFound);
+    server.begin();
+}
+
+static bool wifiIsConnected()
+{
+    return WiFi.status() == WL_CONNECTED;
+}
+
+static void wifiReconnect()
+{
+    WiFi.reconnect();
+}
+
+static void restartAfterWifiLoss()
+{
+    historyFlush();
+    ESP.reset();
+}
+
+static void pressButton(uint8_t command)
+{
+    switch (command)
     {
-        ledToggle(); // LED umschalten
-        delay(500);
-        Serial.print(".");
-        attempts++;
+        case CMD_UP:   moveUp();   break;
+        case CMD_DOWN: moveDown(); break;
+        case CMD_STOP: moveStop(); break;
     }
+}
+
+static const ControlHal controlHal = {
+    wifiBegin, goOnline, scheduleRunning, wifiIsConnected, wifiReconnect, restartAfterWifiLoss,
+    pulseReady, pressButton, ledOff, ledToggle
+};
+
+void setupControlMode() 
+{
+    Serial.println("Starting control mode");
+    isConfigMode = false;
     
-    ledOff(); // LED ausschalten
+    // Pins als Open-Drain, im Ruhezustand freigegeben, so nothing happens if somebody presses keys manually
+    static const uint8_t pulsePins[] = { PIN_UP, PIN_DOWN, PIN_STOP };
+    pulseBegin(pulsePins, sizeof(pulsePins), pulseGapMs);
 
-    if (WiFi.status() == WL_CONNECTED) 
-    {
-        Serial.println();
-        Serial.println(" success");
-        
-        // Homee einrichten
-        setupHomee();
-    } 
-    else 
-    {
-        Serial.println(" failed");
-        Serial.println("Restarting ESP8266...");
-        ESP.reset(); // ESP8266 zurücksetzen, wenn keine Verbindung hergestellt werden kann
+    // Zeitsteuerung vor dem WLAN starten (NTP läuft im Hintergrund), sie läuft auch ohne WLAN
+    scheduleBegin(callBack_scheduleFired);
 
-        // Fallback auf Konfigurationsmodus
-//        setupConfigurationMode();
-    }
+    // WLAN-Verbindung herstellen, loop() läuft währenddessen schon. homee und der Webserver
+    // werden bei der ersten Verbindung eingerichtet (goOnline). Ohne WLAN wird nur neu
+    // gestartet, solange die Zeitsteuerung noch keine Uhrzeit hat.
+    WiFi.mode(WIFI_STA);
+    controlBegin(controlHal);
 
     Serial.println("Setup complete");
 }
@@ -709,6 +1043,9 @@ void setup()
     Serial.println("*******************************************");
     Serial.println("");
 
+    // Reset-Grund auswerten und Loop-Watchdog starten
+    crashlogBegin(loopStallThreshold);
+
     setupLED(); // LED initialisieren
     ledOn(); // LED einschalten
 
@@ -721,6 +1058,10 @@ void setup()
     {
         Serial.println("Failed to mount file system");
     }
+    else
+    {
+        historyBegin();
+    }
     
     // PIN_STOP zuerst als Eingang konfigurieren
     pinMode(PIN_STOP, INPUT_PULLUP);
@@ -728,6 +1069,7 @@ void setup()
     
     // Konfiguration laden
     bool cfgValid = loadConfiguration();
+    scheduleLoadConfig(EEPROM_SCHED_ADDR);
 
 
     if (cfgValid == false) 
@@ -776,11 +1118,11 @@ void setup()
 
 
 static bool loopFirstCall = true;
-static uint32_t wifiConnectAttempts = 0; // Anzahl der Versuche, sich mit dem WLAN zu verbinden
-static bool WiFi_reconnect = false;  //system is in reconnection
 
 void loop() 
 {
+    crashlogLoop();
+
     if (loopFirstCall) 
     {
         loopFirstCall = false;
@@ -791,62 +1133,45 @@ void loop()
     if (isConfigMode) 
     {
         ArduinoOTA.handle();
+        captiveDnsLoop();
+        runDeferredActions();
         yield(); // Wichtig für OTA-Updates;
         // Webserver wird von ESPAsyncWebServer automatisch gehandelt
         return;
     } 
     
     
-    if ((millis() - lastWifiCheckTime >= wifiCheckInterval) || (WiFi_reconnect))
+    // Zeitsteuerung läuft auch ohne WLAN weiter
+    scheduleLoop();
+
+    // Pulsende auswerten
+    if (pulsePoll())
     {
-        lastWifiCheckTime = millis();
-    
-        // Bei Verbindungsverlust erneut verbinden
-        if (WiFi.status() != WL_CONNECTED) 
-        {
-            WiFi_reconnect = true;
-            Serial.println("WiFi connection lost. Reconnecting...");
-            ledToggle(); // LED blinken lassen, um den Verbindungsverlust anzuzeigen
-            WiFi.reconnect();
-            wifiConnectAttempts++;
-            delay(500);
-         }
-
-        if (WiFi.status() == WL_CONNECTED)
+        ledOff(); //simulated button press finished
+        Serial.printf_P(PSTR("Pulse width: %lu us\n"), (unsigned long)pulseLastWidthUs());
+#ifdef PULSE_BENCHMARK
+        if (pulseStats().count % 50 == 0)
         {
-            WiFi_reconnect = false;
-            wifiConnectAttempts = 0; // WLAN-Verbindung erfolgreich
-            ledOff(); // LED ausschalten, wenn WLAN verbunden ist
+            Serial.print(pulseReport());
         }
-
-        if (wifiConnectAttempts >= 20) 
-        {
-            Serial.println("Failed to reconnect to WiFi after 20 attempts. Restarting ESP8266...");
-            ESP.reset(); // ESP8266 zurücksetzen, wenn keine Verbindung hergestellt werden kann
-        }    
+#endif
     }
 
-
-    if (WiFi.status() == WL_CONNECTED)
+#ifdef PULSE_BENCHMARK
+    // Benchmark: regelmäßig STOP drücken, Netzlast von außen erzeugen (z.B. ping -f, homee)
+    static unsigned long lastBenchmarkPulse = 0;
+    if (millis() - lastBenchmarkPulse >= 2000)
     {
-        if (mvUp)
-        {
-            moveUp();
-            mvUp = false;
-        }
+        lastBenchmarkPulse = millis();
+        controlSubmit(CMD_STOP, CMD_SRC_BENCHMARK);
+    }
+#endif
 
-        if (mvDown)
-        {
-            moveDown();
-            mvDown = false;
-        }
+    // WLAN-Überwachung und nächster Tastendruck aus der Warteschlange
+    controlLoop();
 
-        if (mvStop)
-        {
-            moveStop();
-            mvStop = false;
-        }
-    }
+    historyLoop();
+    heapWatchLoop();
 
      yield(); // Wichtig für ESP8266, um den Watchdog zu triggern
 }
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include "pulse.h"
+
+// timer1 läuft mit 80 MHz / 16 = 5 Takten pro µs, maximal 2^23 Takte (ca. 1,6 s)
+const uint32_t TIMER1_TICKS_PER_US = 5;
+const uint32_t TIMER1_MAX_TICKS = 0x7FFFFF;
+
+static volatile bool pulseActive = false;
+static volatile bool pulseFinished = false;
+static volatile uint32_t pulseMask = 0;
+static volatile uint32_t pulseStartCycles = 0;
+static volatile uint32_t pulseEndCycles = 0;
+static uint32_t pulseTargetUs = 0;
+static uint32_t lastWidthUs = 0;
+static unsigned long lastEndMs = 0;
+static unsigned long pulseGapMs = 0;
+static PulseStats stats;
+
+// nur Registerzugriffe, liegt komplett im IRAM
+static void IRAM_ATTR pulseTimerISR()
+{
+    GPOS = pulseMask;                 // Pin freigeben
+    pulseEndCycles = ESP.getCycleCount();
+    pulseActive = false;
+    pulseFinished = true;
+}
+
+void pulseBegin(const uint8_t* pins, uint8_t count, unsigned long gapMs)
+{
+    pulseGapMs = gapMs;
+    memset(&stats, 0, sizeof(stats));
+    stats.minUs = UINT32_MAX;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        // erst freigeben, dann auf Ausgang schalten, damit kein kurzer LOW-Puls entsteht
+        digitalWrite(pins[i], HIGH);
+        pinMode(pins[i], OUTPUT_OPEN_DRAIN);
+    }
+
+    timer1_isr_init();
+    timer1_attachInterrupt(pulseTimerISR);
+}
+
+bool pulseStart(uint8_t pin, uint32_t widthUs)
+{
+    if (pulseActive || pin >= 16)
+    {
+        return false;
+    }
+
+    uint32_t ticks = min(widthUs * TIMER1_TICKS_PER_US, TIMER1_MAX_TICKS);
+    pulseTargetUs = ticks / TIMER1_TICKS_PER_US;
+    pulseMask = (1UL << pin);
+    pulseFinished = false;
+    pulseActive = true;
+
+    // Zeitkritischer Teil ohne Unterbrechung: Pin ziehen, Zeitpunkt merken, Timer starten
+    noInterrupts();
+    GPOC = pulseMask;
+    pulseStartCycles = ESP.getCycleCount();
+    timer1_enable(TIM_DIV16, TIM_EDGE, TIM_SINGLE);
+    timer1_write(ticks);
+    interrupts();
+    return true;
+}
+
+bool pulsePoll()
+{
+    if (!pulseFinished)
+    {
+        return false;
+    }
+    pulseFinished = false;
+    timer1_disable();
+    lastEndMs = millis();
+
+    uint32_t widthUs = (pulseEndCycles - pulseStartCycles) / ESP.getCpuFreqMHz();
+    lastWidthUs = widthUs;
+
+    stats.count++;
+    stats.sumUs += widthUs;
+    stats.minUs = min(stats.minUs, widthUs);
+    stats.maxUs = max(stats.maxUs, widthUs);
+    uint32_t deviation = (widthUs > pulseTargetUs) ? widthUs - pulseTargetUs : 0;
+    stats.hist[min(deviation / PULSE_HIST_STEP_US, (uint32_t)(PULSE_HIST_BUCKETS - 1))]++;
+    return true;
+}
+
+bool pulseReady()
+{
+    return !pulseActive && !pulseFinished && (millis() - lastEndMs >= pulseGapMs);
+}
+
+uint32_t pulseLastWidthUs()
+{
+    return lastWidthUs;
+}
+
+const PulseStats& pulseStats()
+{
+    return stats;
+}
+
+String pulseReport()
+{
+    char buf[80];
+    if (stats.count == 0)
+    {
+        return "no pulses yet\n";
+    }
+
+    snprintf(buf, sizeof(buf), "pulses: %lu, target %lu us, min %lu us, max %lu us, avg %lu us\n",
+             (unsigned long)stats.count, (unsigned long)pulseTargetUs, (unsigned long)stats.minUs,
+             (unsigned long)stats.maxUs, (unsigned long)(stats.sumUs / stats.count));
+    String out = buf;
+    out += "deviation from target:\n";
+    for (uint8_t i = 0; i < PULSE_HIST_BUCKETS; i++)
+    {
+        if (stats.hist[i] == 0)
+        {
+            continue;
+        }
+        if (i < PULSE_HIST_BUCKETS - 1)
+        {
+            snprintf(buf, sizeof(buf), "  %4lu..%4lu us: %lu\n", (unsigned long)(i * PULSE_HIST_STEP_US),
+                     (unsigned long)((i + 1) * PULSE_HIST_STEP_US - 1), (unsigned long)stats.hist[i]);
+        }
+        else
+        {
+            snprintf(buf, sizeof(buf), "  >= %4lu us: %lu\n", (unsigned long)(i * PULSE_HIST_STEP_US),
+                     (unsigned long)stats.hist[i]);
+        }
+        out += buf;
+    }
+    return out;
+}
@@ -0,0 +1,267 @@
+#include "scheduler.h"
+#include "sun.h"
+
+#include <EEPROM.h>
+#include <time.h>
+
+const uint8_t SCHEDULE_MAGIC_BYTE = 0x53;
+const time_t VALID_EPOCH = 1600000000;           // darunter ist die Uhrzeit noch nicht gesetzt
+const time_t SCHEDULE_GRACE = 600;               // verpasste Termine bis 10 Minuten nachholen
+const time_t SCHEDULE_JUMP = 60;                 // Sprung der Uhr, ab dem neu geplant wird
+const unsigned long SCHEDULE_CHECK_INTERVAL = 1000;
+
+ScheduleConfig scheduleConfig;
+
+// lastFire übersteht im RTC-Speicher einen Neustart (WLAN-Verlust, Speichern der Konfiguration),
+// sonst würde ein Termin nach einem Neustart innerhalb der Kulanzzeit ein zweites Mal ausgelöst.
+// Die Prüfsumme schließt die Einträge ein: nach dem Einschalten (Zufallsinhalt) oder einer
+// geänderten Zeitsteuerung wird der Stand verworfen.
+struct ScheduleRtc
+{
+    uint32_t magic;
+    uint32_t lastFire[SCHEDULE_ENTRIES];
+    uint32_t check;
+};
+
+const uint32_t SCHEDULE_RTC_MAGIC = 0x53434844; // "SCHD"
+
+// ab Benutzerblock 64 legt eboot das OTA-Kommando ab
+static_assert(SCHEDULE_RTC_OFFSET * 4 + sizeof(ScheduleRtc) <= 256, "ScheduleRtc overlaps eboot command");
+
+static ScheduleCallback scheduleCallback = nullptr;
+static time_t nextFire[SCHEDULE_ENTRIES];
+static time_t lastFire[SCHEDULE_ENTRIES];   // zuletzt abgearbeiteter Termin je Eintrag
+static time_t nextDue = 0;           // frühester Eintrag aus nextFire, 0 = nichts geplant
+static time_t lastCheckTime = 0;
+static unsigned long lastCheckMillis = 0;
+static bool timeValid = false;
+
+static void setDefaults()
+{
+    memset(&scheduleConfig, 0, sizeof(ScheduleConfig));
+    scheduleConfig.latitude = 52.52f;   // Berlin
+    scheduleConfig.longitude = 13.40f;
+    strcpy(scheduleConfig.timezone, "CET-1CEST,M3.5.0,M10.5.0/3");
+    strcpy(scheduleConfig.ntp_server, "pool.ntp.org");
+    scheduleConfig.checkValue = SCHEDULE_MAGIC_BYTE;
+}
+
+void scheduleLoadConfig(uint16_t eepromAddr)
+{
+    EEPROM.get(eepromAddr, scheduleConfig);
+    if (scheduleConfig.checkValue != SCHEDULE_MAGIC_BYTE)
+    {
+        Serial.println("No valid schedule found, using default values.");
+        setDefaults();
+    }
+    scheduleConfig.timezone[sizeof(scheduleConfig.timezone) - 1] = 0;
+    scheduleConfig.ntp_server[sizeof(scheduleConfig.ntp_server) - 1] = 0;
+}
+
+void scheduleStoreConfig(uint16_t eepromAddr)
+{
+    scheduleConfig.checkValue = SCHEDULE_MAGIC_BYTE;
+    EEPROM.put(eepromAddr, scheduleConfig);
+}
+
+time_t scheduleNextFire(const ScheduleEntry& entry, time_t after)
+{
+    if (entry.type == SCHED_OFF || (entry.weekdays & SCHEDULE_ALL_DAYS) == 0)
+    {
+        return 0;
+    }
+
+    struct tm today;
+    localtime_r(&after, &today);
+
+    // Offsets bis +-12h können das Ereignis auf den Vortag verschieben, daher ab gestern suchen
+    for (int d = -1; d <= 8; d++)
+    {
+        // Tag über 12 Uhr bestimmen, damit die Sommerzeitumstellung nicht stört
+        struct tm day = today;
+        day.tm_mday += d;
+        day.tm_hour = 12;
+        day.tm_min = 0;
+        day.tm_sec = 0;
+        day.tm_isdst = -1;
+        mktime(&day);
+
+        if ((entry.weekdays & (1 << day.tm_wday)) == 0)
+        {
+            continue;
+        }
+
+        time_t fire;
+        if (entry.type == SCHED_FIXED)
+        {
+            day.tm_hour = entry.minutes / 60;
+            day.tm_min = entry.minutes % 60;
+            day.tm_isdst = -1;
+            fire = mktime(&day);
+        }
+        else
+        {
+            int16_t utcMinutes;
+            bool ok = (entry.type == SCHED_SUNRISE)
+                ? sunriseUtc(day.tm_year + 1900, day.tm_mon + 1, day.tm_mday, scheduleConfig.latitude, scheduleConfig.longitude, utcMinutes)
+                : sunsetUtc(day.tm_year + 1900, day.tm_mon + 1, day.tm_mday, scheduleConfig.latitude, scheduleConfig.longitude, utcMinutes);
+            if (!ok)
+            {
+                continue; // Polartag/-nacht
+            }
+            fire = (time_t)daysFromCivil(day.tm_year + 1900, day.tm_mon + 1, day.tm_mday) * 86400
+                 + (time_t)(utcMinutes + entry.minutes) * 60;
+        }
+
+        if (fire > after)
+        {
+            return fire;
+        }
+    }
+    return 0;
+}
+
+static uint32_t rtcCheck(const ScheduleRtc& rtc)
+{
+    // FNV-1a über lastFire und die Einträge
+    uint32_t hash = 2166136261u;
+    const uint8_t* parts[] = { (const uint8_t*)rtc.lastFire, (const uint8_t*)scheduleConfig.entries };
+    const size_t sizes[] = { sizeof(rtc.lastFire), sizeof(scheduleConfig.entries) };
+    for (uint8_t p = 0; p < 2; p++)
+    {
+        for (size_t i = 0; i < sizes[p]; i++)
+        {
+            hash = (hash ^ parts[p][i]) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+static void loadLastFire()
+{
+    ScheduleRtc rtc;
+    ESP.rtcUserMemoryRead(SCHEDULE_RTC_OFFSET, (uint32_t*)&rtc, sizeof(rtc));
+    bool valid = (rtc.magic == SCHEDULE_RTC_MAGIC) && (rtc.check == rtcCheck(rtc));
+    for (uint8_t i = 0; i < SCHEDULE_ENTRIES; i++)
+    {
+        lastFire[i] = valid ? (time_t)rtc.lastFire[i] : 0;
+    }
+}
+
+static void storeLastFire()
+{
+    ScheduleRtc rtc;
+    rtc.magic = SCHEDULE_RTC_MAGIC;
+    for (uint8_t i = 0; i < SCHEDULE_ENTRIES; i++)
+    {
+        rtc.lastFire[i] = (uint32_t)lastFire[i];
+    }
+    rtc.check = rtcCheck(rtc);
+    ESP.rtcUserMemoryWrite(SCHEDULE_RTC_OFFSET, (uint32_t*)&rtc, sizeof(rtc));
+}
+
+static void updateNextDue()
+{
+    nextDue = 0;
+    for (uint8_t i = 0; i < SCHEDULE_ENTRIES; i++)
+    {
+        if (nextFire[i] != 0 && (nextDue == 0 || nextFire[i] < nextDue))
+        {
+            nextDue = nextFire[i];
+        }
+    }
+}
+
+// alle Einträge neu planen; Termine innerhalb der Kulanzzeit vor 'now' werden nachgeholt,
+// aber nie ein bereits abgearbeiteter (Uhr springt zurück, z.B. NTP-Korrektur, oder Neustart)
+static void replan(time_t now)
+{
+    for (uint8_t i = 0; i < SCHEDULE_ENTRIES; i++)
+    {
+        nextFire[i] = scheduleNextFire(scheduleConfig.entries[i], max(now - SCHEDULE_GRACE, lastFire[i]));
+    }
+    updateNextDue();
+
+    if (nextDue != 0)
+    {
+        struct tm t;
+        localtime_r(&nextDue, &t);
+        char buf[24];
+        strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M", &t);
+        Serial.println("Schedule: next event " + String(buf));
+    }
+    else
+    {
+        Serial.println("Schedule: no events planned");
+    }
+}
+
+void scheduleBegin(ScheduleCallback callback)
+{
+    scheduleCallback = callback;
+    memset(nextFire, 0, sizeof(nextFire));
+    loadLastFire();
+    nextDue = 0;
+    timeValid = false;
+
+    configTime(scheduleConfig.timezone, scheduleConfig.ntp_server);
+    Serial.println("Schedule: waiting for time from " + String(scheduleConfig.ntp_server));
+}
+
+bool scheduleRunning()
+{
+    return timeValid && nextDue != 0;
+}
+
+void scheduleLoop()
+{
+    if (millis() - lastCheckMillis < SCHEDULE_CHECK_INTERVAL)
+    {
+        return;
+    }
+    unsigned long elapsed = millis() - lastCheckMillis;
+    lastCheckMillis = millis();
+
+    time_t now = time(nullptr);
+    if (now < VALID_EPOCH)
+    {
+        return; // noch keine Uhrzeit, Zeitsteuerung ruht
+    }
+
+    // erste Synchronisation oder Sprung der Uhr (NTP-Korrektur nach längerem Ausfall)
+    time_t expected = lastCheckTime + (time_t)(elapsed / 1000);
+    if (!timeValid || now > expected + SCHEDULE_JUMP || now < expected - SCHEDULE_JUMP)
+    {
+        if (timeValid)
+        {
+            Serial.println("Schedule: clock adjusted by " + String((long)(now - expected)) + " s");
+        }
+        timeValid = true;
+        replan(now);
+    }
+    lastCheckTime = now;
+
+    if (nextDue == 0 || now < nextDue)
+    {
+        return;
+    }
+
+    for (uint8_t i = 0; i < SCHEDULE_ENTRIES; i++)
+    {
+        if (nextFire[i] == 0 || nextFire[i] > now)
+        {
+            continue;
+        }
+
+        // nach einem Sprung nach vorn keine veralteten Termine auslösen
+        if (now - nextFire[i] <= SCHEDULE_GRACE && scheduleCallback != nullptr)
+        {
+            Serial.println("Schedule: entry " + String(i) + " fired");
+            scheduleCallback(scheduleConfig.entries[i].command);
+        }
+        lastFire[i] = nextFire[i];
+        nextFire[i] = scheduleNextFire(scheduleConfig.entries[i], max(now, nextFire[i]));
+    }
+    storeLastFire();
+    updateNextDue();
+}
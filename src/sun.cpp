@@ -0,0 +1,96 @@
+#include "sun.h"
+
+#include <math.h>
+
+// offizieller Zenit inkl. Refraktion und Sonnenradius
+const double SUN_ZENITH = 90.833;
+
+static double degToRad(double deg)
+{
+    return deg * M_PI / 180.0;
+}
+
+static double radToDeg(double rad)
+{
+    return rad * 180.0 / M_PI;
+}
+
+static double normalize(double value, double range)
+{
+    value = fmod(value, range);
+    return (value < 0) ? value + range : value;
+}
+
+int32_t daysFromCivil(int year, int month, int day)
+{
+    year -= (month <= 2) ? 1 : 0;
+    int32_t era = (year >= 0 ? year : year - 399) / 400;
+    uint32_t yoe = (uint32_t)(year - era * 400);
+    uint32_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int32_t)doe - 719468;
+}
+
+static bool sunEvent(int year, int month, int day, double latitude, double longitude, bool rising, int16_t& minutes)
+{
+    int dayOfYear = daysFromCivil(year, month, day) - daysFromCivil(year, 1, 1) + 1;
+    double lngHour = longitude / 15.0;
+
+    // ungefähre Zeit des Ereignisses
+    double t = dayOfYear + (((rising ? 6.0 : 18.0) - lngHour) / 24.0);
+
+    // mittlere Anomalie und wahre Länge der Sonne
+    double M = (0.9856 * t) - 3.289;
+    double L = normalize(M + (1.916 * sin(degToRad(M))) + (0.020 * sin(degToRad(2 * M))) + 282.634, 360.0);
+
+    // Rektaszension, in den Quadranten von L gelegt, in Stunden
+    double RA = normalize(radToDeg(atan(0.91764 * tan(degToRad(L)))), 360.0);
+    RA += (floor(L / 90.0) * 90.0) - (floor(RA / 90.0) * 90.0);
+    RA /= 15.0;
+
+    // Deklination
+    double sinDec = 0.39782 * sin(degToRad(L));
+    double cosDec = cos(asin(sinDec));
+
+    // Stundenwinkel
+    double cosH = (cos(degToRad(SUN_ZENITH)) - (sinDec * sin(degToRad(latitude)))) / (cosDec * cos(degToRad(latitude)));
+    if (cosH > 1.0 || cosH < -1.0)
+    {
+        return false; // geht an diesem Tag nicht auf bzw. nicht unter
+    }
+
+    double H = radToDeg(acos(cosH));
+    if (rising)
+    {
+        H = 360.0 - H;
+    }
+    H /= 15.0;
+
+    // lokale mittlere Zeit -> UTC
+    double T = H + RA - (0.06571 * t) - 6.622;
+    double UT = normalize(T - lngHour, 24.0);
+
+    // auf den Tag beziehen: Aufgang liegt nahe 6 Uhr, Untergang nahe 18 Uhr Ortszeit
+    double expected = (rising ? 6.0 : 18.0) - lngHour;
+    if (UT - expected > 12.0)
+    {
+        UT -= 24.0;
+    }
+    else if (expected - UT > 12.0)
+    {
+        UT += 24.0;
+    }
+
+    minutes = (int16_t)lround(UT * 60.0);
+    return true;
+}
+
+bool sunriseUtc(int year, int month, int day, double latitude, double longitude, int16_t& minutes)
+{
+    return sunEvent(year, month, day, latitude, longitude, true, minutes);
+}
+
+bool sunsetUtc(int year, int month, int day, double latitude, double longitude, int16_t& minutes)
+{
+    return sunEvent(year, month, day, latitude, longitude, false, minutes);
+}
@@ -0,0 +1,207 @@
+#pragma once
+
+// Minimaler Ersatz für den ESP8266-Core, damit die hardwareunabhängigen Module (history,
+// scheduler, sun, ...) auf dem Host übersetzt und getestet werden können (pio test -e native).
+//
+// millis()/micros() und time() laufen auf einer virtuellen Uhr, die die Tests mit
+// nativeAdvanceMs() vorstellen. Die Uhrzeit gilt wie auf dem ESP erst nach nativeSetTime()
+// als gesetzt, vorher zählt time() die Sekunden seit dem Start.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include <algorithm>
+#include <string>
+
+using std::min;
+using std::max;
+
+#define IRAM_ATTR
+#define PROGMEM
+#define PSTR(s) (s)
+#define F(s) (s)
+
+#define HIGH 1
+#define LOW 0
+
+// virtuelle Uhr in µs; startet auf Wunsch kurz vor dem Überlauf von millis()
+inline uint64_t nativeMicros = 0;
+inline int64_t nativeWallOffset = 0;   // 0 = Uhrzeit nicht gesetzt
+
+inline unsigned long millis() { return (unsigned long)(uint32_t)(nativeMicros / 1000); }
+inline unsigned long micros() { return (unsigned long)(uint32_t)nativeMicros; }
+inline uint64_t micros64() { return nativeMicros; }
+inline void yield() {}
+inline void delay(unsigned long ms) { nativeMicros += (uint64_t)ms * 1000; }
+
+inline void nativeAdvanceMs(uint64_t ms) { nativeMicros += ms * 1000; }
+inline void nativeSetMillis(uint32_t ms) { nativeMicros = (uint64_t)ms * 1000; }
+
+inline time_t nativeTime(time_t* t)
+{
+    time_t now = (time_t)(nativeMicros / 1000000) + (time_t)nativeWallOffset;
+    if (t != nullptr)
+    {
+        *t = now;
+    }
+    return now;
+}
+
+// Systemuhr stellen, wie es SNTP auf dem ESP tut
+inline void nativeSetTime(time_t epoch)
+{
+    nativeWallOffset = (int64_t)epoch - (int64_t)(nativeMicros / 1000000);
+}
+
+// Systemuhr nach einem Neustart: wie auf dem ESP zählt time() wieder ab 0
+inline void nativeClearTime()
+{
+    nativeWallOffset = -(int64_t)(nativeMicros / 1000000);
+}
+
+// time() der Module auf die virtuelle Uhr umlenken
+#define time(t) nativeTime(t)
+
+// SNTP läuft auf dem ESP in lwIP; hier wird nur der Server festgehalten, die Uhrzeit setzen
+// die Tests mit nativeSetTime()
+inline std::string nativeNtpServer;
+
+inline void configTime(const char* tz, const char* server)
+{
+    nativeNtpServer = server;
+    setenv("TZ", tz, 1);
+    tzset();
+}
+
+class String
+{
+public:
+    String() {}
+    String(const char* s) : str(s != nullptr ? s : "") {}
+    String(const std::string& s) : str(s) {}
+    String(char c) : str(1, c) {}
+    String(int v) : str(std::to_string(v)) {}
+    String(unsigned int v) : str(std::to_string(v)) {}
+    String(long v) : str(std::to_string(v)) {}
+    String(unsigned long v) : str(std::to_string(v)) {}
+    String(long long v) : str(std::to_string(v)) {}
+    String(unsigned long long v) : str(std::to_string(v)) {}
+    String(double v, unsigned int decimals = 2)
+    {
+        char buf[48];
+        snprintf(buf, sizeof(buf), "%.*f", (int)decimals, v);
+        str = buf;
+    }
+
+    const char* c_str() const { return str.c_str(); }
+    unsigned int length() const { return (unsigned int)str.length(); }
+    int indexOf(const char* s) const
+    {
+        size_t pos = str.find(s);
+        return pos == std::string::npos ? -1 : (int)pos;
+    }
+    void replace(const String& from, const String& to)
+    {
+        if (from.str.empty())
+        {
+            return;
+        }
+        for (size_t pos = str.find(from.str); pos != std::string::npos; pos = str.find(from.str, pos + to.str.length()))
+        {
+            str.replace(pos, from.str.length(), to.str);
+        }
+    }
+
+    String& operator+=(const String& rhs) { str += rhs.str; return *this; }
+    String& operator+=(const char* rhs) { str += rhs; return *this; }
+    String& operator+=(char rhs) { str += rhs; return *this; }
+    bool operator==(const String& rhs) const { return str == rhs.str; }
+    bool operator==(const char* rhs) const { return str == rhs; }
+
+    friend String operator+(const String& lhs, const String& rhs) { return String(lhs.str + rhs.str); }
+    friend String operator+(const String& lhs, const char* rhs) { return String(lhs.str + rhs); }
+    friend String operator+(const char* lhs, const String& rhs) { return String(lhs + rhs.str); }
+
+private:
+    std::string str;
+};
+
+// Ausgaben der Module, standardmäßig verworfen (nativeSerialEcho = true zeigt sie an)
+inline bool nativeSerialEcho = false;
+
+class NativeSerial
+{
+public:
+    void begin(unsigned long) {}
+    void print(const String& s) { write(s.c_str()); }
+    void print(const char* s) { write(s); }
+    void println(const String& s) { write(s.c_str()); write("\n"); }
+    void println(const char* s = "") { write(s); write("\n"); }
+
+    template <typename... Args>
+    void printf(const char* format, Args... args)
+    {
+        char buf[256];
+        snprintf(buf, sizeof(buf), format, args...);
+        write(buf);
+    }
+
+    template <typename... Args>
+    void printf_P(const char* format, Args... args)
+    {
+        printf(format, args...);
+    }
+
+private:
+    void write(const char* s)
+    {
+        if (nativeSerialEcho)
+        {
+            fputs(s, stdout);
+        }
+    }
+};
+
+inline NativeSerial Serial;
+
+// RTC-Benutzerspeicher des ESP (128 Blöcke zu 4 Byte). Übersteht wie auf dem ESP einen
+// Neustart; nativeRtcClear() entspricht dem Einschalten (Inhalt zufällig).
+class NativeEsp
+{
+public:
+    bool rtcUserMemoryRead(uint32_t offset, uint32_t* data, size_t size)
+    {
+        if (offset * 4 + size > sizeof(rtc))
+        {
+            return false;
+        }
+        memcpy(data, rtc + offset * 4, size);
+        return true;
+    }
+
+    bool rtcUserMemoryWrite(uint32_t offset, uint32_t* data, size_t size)
+    {
+        if (offset * 4 + size > sizeof(rtc))
+        {
+            return false;
+        }
+        memcpy(rtc + offset * 4, data, size);
+        return true;
+    }
+
+    uint8_t rtc[512] = {};
+};
+
+inline NativeEsp ESP;
+
+inline void nativeRtcClear()
+{
+    for (size_t i = 0; i < sizeof(ESP.rtc); i++)
+    {
+        ESP.rtc[i] = (uint8_t)rand();
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+// EEPROM-Emulation im RAM für die Host-Tests
+
+#include <Arduino.h>
+
+class NativeEEPROM
+{
+public:
+    void begin(size_t) {}
+    bool commit() { return true; }
+
+    template <typename T>
+    T& get(int address, T& value)
+    {
+        memcpy(&value, data + address, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    const T& put(int address, const T& value)
+    {
+        memcpy(data + address, &value, sizeof(T));
+        return value;
+    }
+
+private:
+    uint8_t data[4096] = {};
+};
+
+inline NativeEEPROM EEPROM;
@@ -0,0 +1,152 @@
+#pragma once
+
+// LittleFS im RAM für die Host-Tests; Dateien bleiben bis nativeFormat() erhalten,
+// ein "Neustart" (erneutes historyBegin()) sieht also den alten Inhalt.
+
+#include <Arduino.h>
+
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+enum SeekMode
+{
+    SeekSet = 0,
+    SeekCur = 1,
+    SeekEnd = 2
+};
+
+struct NativeFsStats
+{
+    uint32_t opens;
+    uint32_t writes;
+    uint64_t bytesWritten;
+    uint64_t bytesRead;
+};
+
+inline NativeFsStats nativeFsStats;
+
+class File
+{
+public:
+    File() {}
+    File(std::shared_ptr<std::vector<uint8_t>> data, bool writable, size_t pos)
+        : data(data), writable(writable), pos(pos) {}
+
+    explicit operator bool() const { return data != nullptr; }
+
+    size_t read(uint8_t* buf, size_t len)
+    {
+        if (!data || pos >= data->size())
+        {
+            return 0;
+        }
+        size_t n = min(len, data->size() - pos);
+        memcpy(buf, data->data() + pos, n);
+        pos += n;
+        nativeFsStats.bytesRead += n;
+        return n;
+    }
+
+    size_t write(const uint8_t* buf, size_t len)
+    {
+        if (!data || !writable)
+        {
+            return 0;
+        }
+        if (pos + len > data->size())
+        {
+            data->resize(pos + len);
+        }
+        memcpy(data->data() + pos, buf, len);
+        pos += len;
+        nativeFsStats.writes++;
+        nativeFsStats.bytesWritten += len;
+        return len;
+    }
+
+    bool seek(uint32_t offset, SeekMode mode)
+    {
+        if (!data)
+        {
+            return false;
+        }
+        size_t base = (mode == SeekSet) ? 0 : (mode == SeekCur) ? pos : data->size();
+        pos = base + offset;
+        return pos <= data->size();
+    }
+
+    bool truncate(uint32_t size)
+    {
+        if (!data || !writable)
+        {
+            return false;
+        }
+        data->resize(size);
+        pos = min(pos, (size_t)size);
+        return true;
+    }
+
+    size_t size() const { return data ? data->size() : 0; }
+    void close() { data.reset(); }
+
+private:
+    std::shared_ptr<std::vector<uint8_t>> data;
+    bool writable = false;
+    size_t pos = 0;
+};
+
+class NativeFS
+{
+public:
+    bool begin() { return true; }
+
+    bool exists(const String& path) const
+    {
+        return files.count(path.c_str()) > 0 || dirs.count(path.c_str()) > 0;
+    }
+
+    bool mkdir(const String& path)
+    {
+        dirs.insert(path.c_str());
+        return true;
+    }
+
+    bool remove(const String& path)
+    {
+        return files.erase(path.c_str()) > 0;
+    }
+
+    File open(const String& path, const char* mode)
+    {
+        nativeFsStats.opens++;
+        auto it = files.find(path.c_str());
+        if (mode[0] == 'r')
+        {
+            if (it == files.end())
+            {
+                return File();
+            }
+            return File(it->second, mode[1] == '+', 0);
+        }
+        if (it == files.end() || mode[0] == 'w')
+        {
+            files[path.c_str()] = std::make_shared<std::vector<uint8_t>>();
+            it = files.find(path.c_str());
+        }
+        return File(it->second, true, mode[0] == 'a' ? it->second->size() : 0);
+    }
+
+    void nativeFormat()
+    {
+        files.clear();
+        dirs.clear();
+    }
+
+private:
+    std::map<std::string, std::shared_ptr<std::vector<uint8_t>>> files;
+    std::set<std::string> dirs;
+};
+
+inline NativeFS LittleFS;
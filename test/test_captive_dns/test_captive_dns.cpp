@@ -0,0 +1,229 @@
+// Host-Test des Captive-Portal-DNS (pio test -e native -f test_captive_dns)
+//
+// Ein DNS-Client fragt über echte UDP-Sockets auf 127.0.0.1 an, der "Server" beantwortet die
+// Pakete mit captiveDnsReply() wie loop() auf dem ESP.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "captivedns.h"
+
+static const uint8_t AP_IP[4] = { 192, 168, 4, 1 };
+const uint16_t TYPE_A = 1;
+const uint16_t TYPE_AAAA = 28;
+const uint16_t TYPE_OPT = 41;
+
+static int serverSocket = -1;
+static int clientSocket = -1;
+static sockaddr_in serverAddr;
+
+static int openSocket()
+{
+    int s = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    bind(s, (sockaddr*)&addr, sizeof(addr));
+    timeval timeout = { 1, 0 };
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return s;
+}
+
+// Anfrage wie ein Stub-Resolver: RD gesetzt, optional mit EDNS-Eintrag
+static std::vector<uint8_t> buildQuery(uint16_t id, const char* name, uint16_t type, bool edns = true)
+{
+    std::vector<uint8_t> q = { (uint8_t)(id >> 8), (uint8_t)id, 0x01, 0x00, 0, 1, 0, 0, 0, 0, 0, (uint8_t)(edns ? 1 : 0) };
+    const char* label = name;
+    while (*label)
+    {
+        const char* dot = strchr(label, '.');
+        size_t len = dot ? (size_t)(dot - label) : strlen(label);
+        q.push_back((uint8_t)len);
+        q.insert(q.end(), label, label + len);
+        label += len + (dot ? 1 : 0);
+    }
+    q.push_back(0);
+    q.insert(q.end(), { (uint8_t)(type >> 8), (uint8_t)type, 0, 1 });
+    if (edns)
+    {
+        q.insert(q.end(), { 0, (uint8_t)(TYPE_OPT >> 8), (uint8_t)TYPE_OPT, 0x04, 0xD0, 0, 0, 0, 0, 0, 0 });
+    }
+    return q;
+}
+
+// ein Paket serverseitig empfangen und beantworten; Rückgabe: Länge der Antwort
+static size_t serveOne()
+{
+    uint8_t packet[CAPTIVE_DNS_MAX_PACKET + 64];
+    uint8_t reply[CAPTIVE_DNS_MAX_PACKET];
+    sockaddr_in from;
+    socklen_t fromLen = sizeof(from);
+    ssize_t n = recvfrom(serverSocket, packet, sizeof(packet), 0, (sockaddr*)&from, &fromLen);
+    TEST_ASSERT_TRUE(n > 0);
+    size_t len = captiveDnsReply(packet, (size_t)n, reply, sizeof(reply), AP_IP);
+    if (len > 0)
+    {
+        sendto(serverSocket, reply, len, 0, (sockaddr*)&from, fromLen);
+    }
+    return len;
+}
+
+// Anfrage senden, beantworten lassen und Antwort des Clients liefern (leer bei Timeout)
+static std::vector<uint8_t> exchange(const std::vector<uint8_t>& query)
+{
+    sendto(clientSocket, query.data(), query.size(), 0, (sockaddr*)&serverAddr, sizeof(serverAddr));
+    if (serveOne() == 0)
+    {
+        return {};
+    }
+    std::vector<uint8_t> reply(CAPTIVE_DNS_MAX_PACKET);
+    ssize_t n = recv(clientSocket, reply.data(), reply.size(), 0);
+    reply.resize(n > 0 ? (size_t)n : 0);
+    return reply;
+}
+
+static uint16_t get16(const std::vector<uint8_t>& p, size_t pos)
+{
+    return (uint16_t)((p[pos] << 8) | p[pos + 1]);
+}
+
+void setUp()
+{
+    serverSocket = openSocket();
+    clientSocket = openSocket();
+    socklen_t len = sizeof(serverAddr);
+    getsockname(serverSocket, (sockaddr*)&serverAddr, &len);
+}
+
+void tearDown()
+{
+    close(serverSocket);
+    close(clientSocket);
+}
+
+void test_a_query_answered_with_ap_ip()
+{
+    std::vector<uint8_t> q = buildQuery(0x1234, "connectivitycheck.gstatic.com", TYPE_A);
+    std::vector<uint8_t> r = exchange(q);
+    size_t question = q.size() - 11;   // ohne EDNS-Eintrag
+
+    TEST_ASSERT_EQUAL(question + 16, r.size());
+    TEST_ASSERT_EQUAL_UINT16(0x1234, get16(r, 0));
+    TEST_ASSERT_EQUAL_UINT16(0x8500, get16(r, 2));   // Antwort, autoritativ, RD, NOERROR
+    TEST_ASSERT_EQUAL_UINT16(1, get16(r, 4));
+    TEST_ASSERT_EQUAL_UINT16(1, get16(r, 6));
+    TEST_ASSERT_EQUAL_UINT16(0, get16(r, 10));
+    TEST_ASSERT_EQUAL_MEMORY(q.data() + 12, r.data() + 12, question - 12);
+
+    TEST_ASSERT_EQUAL_UINT16(0xC00C, get16(r, question));
+    TEST_ASSERT_EQUAL_UINT16(TYPE_A, get16(r, question + 2));
+    TEST_ASSERT_EQUAL_UINT16(1, get16(r, question + 4));
+    TEST_ASSERT_EQUAL_UINT16(CAPTIVE_DNS_TTL, get16(r, question + 8));
+    TEST_ASSERT_EQUAL_UINT16(4, get16(r, question + 10));
+    TEST_ASSERT_EQUAL_MEMORY(AP_IP, r.data() + question + 12, 4);
+}
+
+void test_probe_hosts_of_all_platforms()
+{
+    const char* const hosts[] = {
+        "captive.apple.com", "www.msftconnecttest.com", "detectportal.firefox.com",
+        "clients3.google.com", "nmcheck.gnome.org", "example"
+    };
+    uint16_t id = 1;
+    for (const char* host : hosts)
+    {
+        std::vector<uint8_t> r = exchange(buildQuery(id, host, TYPE_A, false));
+        TEST_ASSERT_TRUE_MESSAGE(r.size() > 16, host);
+        TEST_ASSERT_EQUAL_UINT16(id, get16(r, 0));
+        TEST_ASSERT_EQUAL_MEMORY(AP_IP, r.data() + r.size() - 4, 4);
+        id++;
+    }
+}
+
+void test_aaaa_gets_empty_answer()
+{
+    std::vector<uint8_t> r = exchange(buildQuery(7, "captive.apple.com", TYPE_AAAA));
+    TEST_ASSERT_TRUE(r.size() > 12);
+    TEST_ASSERT_EQUAL_UINT16(0x8500, get16(r, 2));   // NOERROR, keine Daten
+    TEST_ASSERT_EQUAL_UINT16(0, get16(r, 6));
+}
+
+void test_other_opcode_not_implemented()
+{
+    std::vector<uint8_t> q = buildQuery(9, "example.com", TYPE_A, false);
+    q[2] = 0x28;   // UPDATE
+    std::vector<uint8_t> r = exchange(q);
+    TEST_ASSERT_EQUAL(12, r.size());
+    TEST_ASSERT_EQUAL_UINT16(0xA804, get16(r, 2));
+    TEST_ASSERT_EQUAL_UINT16(0, get16(r, 4));
+}
+
+void test_malformed_packets_dropped()
+{
+    uint8_t reply[CAPTIVE_DNS_MAX_PACKET];
+
+    std::vector<uint8_t> q = buildQuery(1, "example.com", TYPE_A, false);
+    std::vector<uint8_t> truncated(q.begin(), q.end() - 3);
+    TEST_ASSERT_EQUAL(0, captiveDnsReply(truncated.data(), truncated.size(), reply, sizeof(reply), AP_IP));
+    TEST_ASSERT_EQUAL(0, captiveDnsReply(q.data(), 11, reply, sizeof(reply), AP_IP));
+
+    std::vector<uint8_t> response = q;
+    response[2] |= 0x80;
+    TEST_ASSERT_EQUAL(0, captiveDnsReply(response.data(), response.size(), reply, sizeof(reply), AP_IP));
+
+    std::vector<uint8_t> twoQuestions = q;
+    twoQuestions[5] = 2;
+    TEST_ASSERT_EQUAL(0, captiveDnsReply(twoQuestions.data(), twoQuestions.size(), reply, sizeof(reply), AP_IP));
+
+    std::vector<uint8_t> pointer = q;
+    pointer[12] = 0xC0;
+    TEST_ASSERT_EQUAL(0, captiveDnsReply(pointer.data(), pointer.size(), reply, sizeof(reply), AP_IP));
+
+    // Label-Länge zeigt über das Paketende hinaus
+    std::vector<uint8_t> overrun = q;
+    overrun[12] = 63;
+    TEST_ASSERT_EQUAL(0, captiveDnsReply(overrun.data(), overrun.size(), reply, sizeof(reply), AP_IP));
+
+    // über UDP: verworfene Pakete bleiben unbeantwortet
+    TEST_ASSERT_EQUAL(0, exchange(response).size());
+}
+
+void test_name_length_and_reply_buffer_limits()
+{
+    uint8_t reply[CAPTIVE_DNS_MAX_PACKET];
+    std::string longName;
+    for (int i = 0; i < 4; i++)
+    {
+        longName += std::string(63, 'a' + i) + (i < 3 ? "." : "");
+    }
+    std::vector<uint8_t> q = buildQuery(1, longName.c_str(), TYPE_A, false);   // 257 Byte kodiert
+    TEST_ASSERT_EQUAL(0, captiveDnsReply(q.data(), q.size(), reply, sizeof(reply), AP_IP));
+
+    longName.resize(longName.size() - 2);   // 255 Byte, gerade noch zulässig
+    q = buildQuery(1, longName.c_str(), TYPE_A, false);
+    TEST_ASSERT_EQUAL(q.size() + 16, captiveDnsReply(q.data(), q.size(), reply, sizeof(reply), AP_IP));
+
+    // zu kleiner Antwortpuffer: verwerfen statt überschreiben
+    TEST_ASSERT_EQUAL(0, captiveDnsReply(q.data(), q.size(), reply, q.size() + 15, AP_IP));
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_a_query_answered_with_ap_ip);
+    RUN_TEST(test_probe_hosts_of_all_platforms);
+    RUN_TEST(test_aaaa_gets_empty_answer);
+    RUN_TEST(test_other_opcode_not_implemented);
+    RUN_TEST(test_malformed_packets_dropped);
+    RUN_TEST(test_name_length_and_reply_buffer_limits);
+    return UNITY_END();
+}
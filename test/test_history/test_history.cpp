@@ -0,0 +1,258 @@
+// Host-Tests und Benchmark der Ereignis-Historie (pio test -e native -f test_history)
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <unity.h>
+
+#include <chrono>
+
+#include "history.h"
+
+const uint32_t T0 = 1700000000;   // 2023-11-14, gültige Uhrzeit
+
+static void restart()
+{
+    historyFlush();
+    historyBegin();
+}
+
+// Datensätze im Sekundenabstand ab T0 anlegen, wie sie loop() schreiben würde
+static void appendRecords(uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        historyAdd(HIST_SRC_HOMEE, i % 3, HIST_RES_EXECUTED);
+        nativeAdvanceMs(1000);
+        historyLoop();
+    }
+}
+
+static uint32_t readAll(uint32_t from, uint32_t to, uint32_t* first, uint32_t* last)
+{
+    HistoryCursor cursor;
+    HistoryRecord records[8];
+    uint32_t total = 0;
+    uint32_t prev = 0;
+    historyQuery(from, to, cursor);
+    while (!cursor.done)
+    {
+        size_t n = historyRead(cursor, records, 8);
+        for (size_t i = 0; i < n; i++)
+        {
+            TEST_ASSERT_TRUE(records[i].time >= from && records[i].time <= to);
+            TEST_ASSERT_TRUE(records[i].time >= prev);
+            prev = records[i].time;
+            if (total == 0 && first != nullptr)
+            {
+                *first = records[i].time;
+            }
+            total++;
+        }
+    }
+    if (last != nullptr)
+    {
+        *last = prev;
+    }
+    return total;
+}
+
+void setUp()
+{
+    historyFlush();
+    LittleFS.nativeFormat();
+    nativeMicros = 0;
+    nativeSetTime(T0);
+    historyBegin();
+}
+
+void tearDown()
+{
+}
+
+void test_add_never_writes_flash()
+{
+    NativeFsStats before = nativeFsStats;
+    for (uint8_t i = 0; i < HISTORY_BATCH_SIZE + 4; i++)
+    {
+        historyAdd(HIST_SRC_HOMEE, 0, HIST_RES_REJECTED);
+    }
+    TEST_ASSERT_EQUAL_UINT32(before.opens, nativeFsStats.opens);
+    TEST_ASSERT_EQUAL_UINT32(before.writes, nativeFsStats.writes);
+
+    // voller Puffer: die ältesten Einträge fallen weg, geschrieben wird erst in historyLoop()
+    historyLoop();
+    TEST_ASSERT_GREATER_THAN(before.writes, nativeFsStats.writes);
+    TEST_ASSERT_EQUAL_UINT32(HISTORY_BATCH_SIZE, readAll(0, UINT32_MAX, nullptr, nullptr));
+}
+
+void test_flush_threshold_and_interval()
+{
+    for (uint8_t i = 0; i < HISTORY_FLUSH_THRESHOLD - 1; i++)
+    {
+        historyAdd(HIST_SRC_SCHEDULE, 1, HIST_RES_EXECUTED);
+    }
+    uint32_t writes = nativeFsStats.writes;
+    historyLoop();
+    TEST_ASSERT_EQUAL_UINT32(writes, nativeFsStats.writes);
+
+    historyAdd(HIST_SRC_SCHEDULE, 1, HIST_RES_EXECUTED);
+    historyLoop();
+    TEST_ASSERT_GREATER_THAN(writes, nativeFsStats.writes);
+
+    // einzelner Eintrag wird erst nach HISTORY_FLUSH_INTERVAL geschrieben
+    writes = nativeFsStats.writes;
+    historyAdd(HIST_SRC_SCHEDULE, 1, HIST_RES_EXECUTED);
+    nativeAdvanceMs(HISTORY_FLUSH_INTERVAL - 1);
+    historyLoop();
+    TEST_ASSERT_EQUAL_UINT32(writes, nativeFsStats.writes);
+    nativeAdvanceMs(1);
+    historyLoop();
+    TEST_ASSERT_EQUAL_UINT32(writes + 1, nativeFsStats.writes);
+}
+
+void test_query_sees_unflushed_records()
+{
+    appendRecords(305);   // die letzten 5 Einträge liegen noch im Puffer
+    uint32_t first, last;
+    TEST_ASSERT_EQUAL_UINT32(305, readAll(0, UINT32_MAX, &first, &last));
+    TEST_ASSERT_EQUAL_UINT32(T0, first);
+    TEST_ASSERT_EQUAL_UINT32(T0 + 304, last);
+
+    // nur ungeschriebene Einträge im Bereich
+    TEST_ASSERT_EQUAL_UINT32(5, readAll(T0 + 300, UINT32_MAX, &first, nullptr));
+    TEST_ASSERT_EQUAL_UINT32(T0 + 300, first);
+}
+
+void test_cursor_survives_flush()
+{
+    // Kopfsegment bis auf 4 Plätze füllen, der Puffer reicht dann ins nächste Segment
+    appendRecords(HISTORY_RECORDS_PER_SEGMENT - 4);
+    historyFlush();
+    for (uint8_t i = 0; i < 10; i++)
+    {
+        historyAdd(HIST_SRC_SYSTEM, 2, HIST_RES_EXECUTED);
+        nativeAdvanceMs(1000);
+    }
+
+    HistoryCursor cursor;
+    HistoryRecord records[3];
+    historyQuery(T0 + HISTORY_RECORDS_PER_SEGMENT - 6, UINT32_MAX, cursor);
+    TEST_ASSERT_EQUAL(3, historyRead(cursor, records, 3));
+    TEST_ASSERT_EQUAL_UINT32(T0 + HISTORY_RECORDS_PER_SEGMENT - 6, records[0].time);
+
+    historyFlush();   // Puffer landet genau an den Positionen, auf die der Cursor zeigt
+    uint32_t expected = records[2].time + 1;
+    uint32_t count = 0;
+    while (!cursor.done)
+    {
+        size_t n = historyRead(cursor, records, 3);
+        for (size_t i = 0; i < n; i++)
+        {
+            TEST_ASSERT_EQUAL_UINT32(expected++, records[i].time);
+            count++;
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(9, count);
+}
+
+void test_ring_keeps_newest_segments()
+{
+    const uint32_t total = HISTORY_SEGMENTS * HISTORY_RECORDS_PER_SEGMENT + 1000;
+    appendRecords(total);
+    historyFlush();
+
+    uint32_t first, last;
+    uint32_t kept = readAll(0, UINT32_MAX, &first, &last);
+    TEST_ASSERT_TRUE(kept > (HISTORY_SEGMENTS - 1) * HISTORY_RECORDS_PER_SEGMENT);
+    TEST_ASSERT_TRUE(kept <= HISTORY_SEGMENTS * HISTORY_RECORDS_PER_SEGMENT);
+    TEST_ASSERT_EQUAL_UINT32(T0 + total - 1, last);
+    TEST_ASSERT_EQUAL_UINT32(T0 + total - kept, first);
+
+    TEST_ASSERT_EQUAL_UINT32(101, readAll(T0 + total - 500, T0 + total - 400, &first, &last));
+    TEST_ASSERT_EQUAL_UINT32(T0 + total - 500, first);
+    TEST_ASSERT_EQUAL_UINT32(T0 + total - 400, last);
+    TEST_ASSERT_EQUAL_UINT32(0, readAll(T0 + total, UINT32_MAX, nullptr, nullptr));
+}
+
+void test_restart_with_empty_head_segment()
+{
+    appendRecords(HISTORY_RECORDS_PER_SEGMENT);
+    historyFlush();
+
+    // Stromausfall direkt nach dem Anlegen des nächsten Segments: Kopf ist leer
+    File f = LittleFS.open("/hist/seg1.bin", "w");
+    const uint32_t header[2] = { 0x54534948, 2 };
+    f.write((const uint8_t*)header, sizeof(header));
+    f.close();
+
+    // ohne Uhrzeit nach dem Neustart darf die Pseudo-Zeit nicht hinter das Log zurückfallen
+    nativeMicros = 0;
+    nativeWallOffset = 0;
+    restart();
+    historyAdd(HIST_SRC_SYSTEM, 2, HIST_RES_EXECUTED);
+    historyFlush();
+
+    uint32_t last;
+    TEST_ASSERT_EQUAL_UINT32(HISTORY_RECORDS_PER_SEGMENT + 1, readAll(0, UINT32_MAX, nullptr, &last));
+    TEST_ASSERT_TRUE(last > T0 + HISTORY_RECORDS_PER_SEGMENT - 1);
+}
+
+// Aufwand einer Bereichsabfrage bei vollem Ring: Positionieren per binärer Suche muss mit
+// wenigen Dateizugriffen auskommen, unabhängig von der Position im Log
+void test_benchmark_append_and_query()
+{
+    const uint32_t total = HISTORY_SEGMENTS * HISTORY_RECORDS_PER_SEGMENT;
+    NativeFsStats before = nativeFsStats;
+    auto start = std::chrono::steady_clock::now();
+    appendRecords(total);
+    historyFlush();
+    double appendUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    uint32_t appendWrites = nativeFsStats.writes - before.writes;
+
+    // höchstens ein Schreibzugriff je Block plus Segmentköpfe
+    TEST_ASSERT_LESS_OR_EQUAL(total / HISTORY_FLUSH_THRESHOLD + 2 * HISTORY_SEGMENTS, appendWrites);
+
+    uint32_t oldest;
+    readAll(0, UINT32_MAX, &oldest, nullptr);
+
+    uint32_t maxOpens = 0;
+    uint64_t maxBytes = 0;
+    const uint32_t queries = 1000;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t q = 0; q < queries; q++)
+    {
+        uint32_t from = oldest + (q * 7919) % (T0 + total - oldest);
+        NativeFsStats s = nativeFsStats;
+        HistoryCursor cursor;
+        historyQuery(from, UINT32_MAX, cursor);
+        HistoryRecord rec;
+        TEST_ASSERT_EQUAL(1, historyRead(cursor, &rec, 1));
+        TEST_ASSERT_EQUAL_UINT32(from, rec.time);
+        maxOpens = max(maxOpens, nativeFsStats.opens - s.opens);
+        maxBytes = max(maxBytes, nativeFsStats.bytesRead - s.bytesRead);
+    }
+    double queryUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / queries;
+
+    // Suche im Segment: log2(256) + 1 Zeitstempel, dazu der gelesene Datensatz
+    TEST_ASSERT_LESS_OR_EQUAL(2, maxOpens);
+    TEST_ASSERT_LESS_OR_EQUAL(11 * sizeof(HistoryRecord), maxBytes);
+
+    char msg[160];
+    snprintf(msg, sizeof(msg), "append %lu records: %.0f us, %lu writes; query: %.2f us, max %lu opens, %lu bytes read",
+             (unsigned long)total, appendUs, (unsigned long)appendWrites, queryUs, (unsigned long)maxOpens,
+             (unsigned long)maxBytes);
+    TEST_MESSAGE(msg);
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_add_never_writes_flash);
+    RUN_TEST(test_flush_threshold_and_interval);
+    RUN_TEST(test_query_sees_unflushed_records);
+    RUN_TEST(test_cursor_survives_flush);
+    RUN_TEST(test_ring_keeps_newest_segments);
+    RUN_TEST(test_restart_with_empty_head_segment);
+    RUN_TEST(test_benchmark_append_and_query);
+    return UNITY_END();
+}
@@ -0,0 +1,338 @@
+// Host-Tests für Sonnenstand und Zeitsteuerung (pio test -e native -f test_schedule)
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "scheduler.h"
+#include "sun.h"
+
+const char* const TZ_BERLIN = "CET-1CEST,M3.5.0,M10.5.0/3";
+const char* const TZ_SYDNEY = "AEST-10AEDT,M10.1.0,M4.1.0/3";
+
+// Vergleichswerte aus Sonnenauf-/-untergangstabellen, Algorithmus ist auf ca. 1-2 min genau
+const int SUN_TOLERANCE = 4;
+
+static uint8_t fired = 0;
+static uint8_t firedCommand = 0xFF;
+
+static void onFire(uint8_t command)
+{
+    fired++;
+    firedCommand = command;
+}
+
+static time_t localTime(int year, int month, int day, int hour, int minute)
+{
+    struct tm t = {};
+    t.tm_year = year - 1900;
+    t.tm_mon = month - 1;
+    t.tm_mday = day;
+    t.tm_hour = hour;
+    t.tm_min = minute;
+    t.tm_isdst = -1;
+    return mktime(&t);
+}
+
+static void useLocation(float latitude, float longitude, const char* tz)
+{
+    scheduleConfig.latitude = latitude;
+    scheduleConfig.longitude = longitude;
+    strcpy(scheduleConfig.timezone, tz);
+    setenv("TZ", tz, 1);
+    tzset();
+}
+
+static ScheduleEntry entry(uint8_t type, int16_t minutes, uint8_t weekdays = SCHEDULE_ALL_DAYS)
+{
+    ScheduleEntry e = {};
+    e.type = type;
+    e.command = 1;
+    e.weekdays = weekdays;
+    e.minutes = minutes;
+    return e;
+}
+
+// Neustart des ESP: millis() und Systemuhr beginnen bei 0, der RTC-Speicher bleibt erhalten
+static void restart()
+{
+    nativeMicros = 0;
+    nativeClearTime();
+    scheduleBegin(onFire);
+}
+
+// loop() im Sekundentakt nachbilden
+static void runSeconds(uint32_t seconds)
+{
+    for (uint32_t i = 0; i < seconds; i++)
+    {
+        nativeAdvanceMs(1000);
+        scheduleLoop();
+    }
+}
+
+void setUp()
+{
+    memset(&scheduleConfig, 0, sizeof(scheduleConfig));
+    useLocation(52.52f, 13.40f, TZ_BERLIN);
+    fired = 0;
+    firedCommand = 0xFF;
+    nativeRtcClear();
+}
+
+void tearDown()
+{
+}
+
+void test_days_from_civil()
+{
+    TEST_ASSERT_EQUAL_INT(0, daysFromCivil(1970, 1, 1));
+    TEST_ASSERT_EQUAL_INT(-1, daysFromCivil(1969, 12, 31));
+    TEST_ASSERT_EQUAL_INT(11016, daysFromCivil(2000, 2, 29));
+    TEST_ASSERT_EQUAL_INT(20744, daysFromCivil(2026, 10, 18));
+}
+
+void test_sun_mid_latitudes()
+{
+    int16_t rise, set;
+    // Berlin, Sommeranfang: 04:43 / 21:33 MESZ
+    TEST_ASSERT_TRUE(sunriseUtc(2026, 6, 21, 52.52, 13.40, rise));
+    TEST_ASSERT_TRUE(sunsetUtc(2026, 6, 21, 52.52, 13.40, set));
+    TEST_ASSERT_INT_WITHIN(SUN_TOLERANCE, 2 * 60 + 43, rise);
+    TEST_ASSERT_INT_WITHIN(SUN_TOLERANCE, 19 * 60 + 33, set);
+
+    // Greenwich, Tagundnachtgleiche: 06:03 / 18:14 GMT
+    TEST_ASSERT_TRUE(sunriseUtc(2026, 3, 20, 51.48, 0.0, rise));
+    TEST_ASSERT_TRUE(sunsetUtc(2026, 3, 20, 51.48, 0.0, set));
+    TEST_ASSERT_INT_WITHIN(SUN_TOLERANCE, 6 * 60 + 3, rise);
+    TEST_ASSERT_INT_WITHIN(SUN_TOLERANCE, 18 * 60 + 14, set);
+}
+
+void test_sun_event_on_other_utc_day()
+{
+    int16_t rise, set;
+    // Sydney, Winteranfang: 07:00 / 16:54 AEST, Aufgang liegt am UTC-Vortag
+    TEST_ASSERT_TRUE(sunriseUtc(2026, 6, 21, -33.87, 151.21, rise));
+    TEST_ASSERT_TRUE(sunsetUtc(2026, 6, 21, -33.87, 151.21, set));
+    TEST_ASSERT_INT_WITHIN(SUN_TOLERANCE, -3 * 60, rise);
+    TEST_ASSERT_INT_WITHIN(SUN_TOLERANCE, 6 * 60 + 54, set);
+
+    // Los Angeles: Untergang 19:05 PDT liegt am UTC-Folgetag
+    TEST_ASSERT_TRUE(sunsetUtc(2026, 3, 20, 34.05, -118.24, set));
+    TEST_ASSERT_INT_WITHIN(SUN_TOLERANCE, 26 * 60 + 5, set);
+}
+
+void test_sun_polar_day_and_night()
+{
+    int16_t minutes;
+    // Tromsø: Mitternachtssonne im Juni, Polarnacht im Dezember
+    TEST_ASSERT_FALSE(sunriseUtc(2026, 6, 21, 69.65, 18.96, minutes));
+    TEST_ASSERT_FALSE(sunsetUtc(2026, 6, 21, 69.65, 18.96, minutes));
+    TEST_ASSERT_FALSE(sunriseUtc(2026, 12, 21, 69.65, 18.96, minutes));
+    TEST_ASSERT_TRUE(sunriseUtc(2026, 3, 20, 69.65, 18.96, minutes));
+}
+
+void test_fixed_time_across_dst()
+{
+    ScheduleEntry e = entry(SCHED_FIXED, 7 * 60);
+
+    // Umstellung auf Sommerzeit in der Nacht zum 29.03.2026: weiter 07:00 Ortszeit
+    time_t fire = scheduleNextFire(e, localTime(2026, 3, 28, 8, 0));
+    TEST_ASSERT_EQUAL_INT64(localTime(2026, 3, 29, 7, 0), fire);
+    TEST_ASSERT_EQUAL_INT64(1774760400, fire);   // 05:00 UTC
+
+    // Umstellung auf Winterzeit in der Nacht zum 25.10.2026
+    fire = scheduleNextFire(e, localTime(2026, 10, 24, 8, 0));
+    TEST_ASSERT_EQUAL_INT64(1792908000, fire);   // 06:00 UTC
+
+    // Termin in der übersprungenen Stunde wird trotzdem am selben Tag ausgeführt
+    e.minutes = 2 * 60 + 30;
+    fire = scheduleNextFire(e, localTime(2026, 3, 28, 12, 0));
+    TEST_ASSERT_TRUE(fire > localTime(2026, 3, 29, 0, 0) && fire <= localTime(2026, 3, 29, 4, 0));
+}
+
+void test_weekday_mask()
+{
+    ScheduleEntry e = entry(SCHED_FIXED, 6 * 60 + 30, 1 << 1);   // nur montags
+    time_t fire = scheduleNextFire(e, localTime(2026, 10, 18, 12, 0));   // Sonntag
+    TEST_ASSERT_EQUAL_INT64(localTime(2026, 10, 19, 6, 30), fire);
+    fire = scheduleNextFire(e, fire);
+    TEST_ASSERT_EQUAL_INT64(localTime(2026, 10, 26, 6, 30), fire);
+
+    e.weekdays = 0;
+    TEST_ASSERT_EQUAL_INT64(0, scheduleNextFire(e, fire));
+}
+
+void test_sunrise_follows_sun_not_clock_change()
+{
+    // Sonnenaufgang + 30 min: über die Zeitumstellung ändert sich die UTC-Zeit nur um Minuten
+    ScheduleEntry e = entry(SCHED_SUNRISE, 30);
+    time_t before = scheduleNextFire(e, localTime(2026, 3, 28, 0, 0));
+    time_t after = scheduleNextFire(e, before);
+    TEST_ASSERT_INT_WITHIN(5 * 60, 86400 - 2 * 60, after - before);
+
+    struct tm t;
+    localtime_r(&after, &t);
+    TEST_ASSERT_EQUAL_INT(29, t.tm_mday);
+    TEST_ASSERT_EQUAL_INT(1, t.tm_isdst);
+}
+
+void test_sunrise_southern_hemisphere_local_date()
+{
+    useLocation(-33.87f, 151.21f, TZ_SYDNEY);
+    ScheduleEntry e = entry(SCHED_SUNRISE, 0);
+    time_t fire = scheduleNextFire(e, localTime(2026, 6, 20, 12, 0));
+    TEST_ASSERT_INT_WITHIN(SUN_TOLERANCE * 60, localTime(2026, 6, 21, 7, 0), fire);
+
+    // Untergang - 15 min
+    e = entry(SCHED_SUNSET, -15);
+    fire = scheduleNextFire(e, localTime(2026, 6, 21, 12, 0));
+    TEST_ASSERT_INT_WITHIN(SUN_TOLERANCE * 60, localTime(2026, 6, 21, 16, 39), fire);
+}
+
+void test_sunrise_skips_polar_days()
+{
+    useLocation(69.65f, 18.96f, "CET-1CEST,M3.5.0,M10.5.0/3");
+    ScheduleEntry e = entry(SCHED_SUNRISE, 0);
+    TEST_ASSERT_EQUAL_INT64(0, scheduleNextFire(e, localTime(2026, 6, 10, 12, 0)));
+    TEST_ASSERT_TRUE(scheduleNextFire(e, localTime(2026, 3, 20, 12, 0)) > 0);
+}
+
+void test_loop_fires_once_despite_clock_jump_back()
+{
+    scheduleConfig.entries[0] = entry(SCHED_FIXED, 7 * 60);
+    nativeMicros = 0;
+    nativeSetTime(localTime(2026, 10, 19, 6, 58));
+    scheduleBegin(onFire);
+    runSeconds(3 * 60);
+    TEST_ASSERT_EQUAL_UINT8(1, fired);
+    TEST_ASSERT_EQUAL_UINT8(1, firedCommand);
+
+    // NTP-Korrektur um 5 min zurück: der Termin liegt wieder in der Zukunft
+    nativeSetTime(localTime(2026, 10, 19, 6, 56));
+    runSeconds(20 * 60);
+    TEST_ASSERT_EQUAL_UINT8(1, fired);
+
+    // am nächsten Tag wieder
+    nativeSetTime(localTime(2026, 10, 20, 6, 59));
+    runSeconds(2 * 60);
+    TEST_ASSERT_EQUAL_UINT8(2, fired);
+}
+
+void test_loop_catches_up_within_grace_only()
+{
+    scheduleConfig.entries[0] = entry(SCHED_FIXED, 7 * 60);
+
+    // Einschalten 5 min nach dem Termin (RTC-Speicher leer): wird nachgeholt
+    nativeMicros = 0;
+    nativeSetTime(localTime(2026, 10, 19, 7, 5));
+    scheduleBegin(onFire);
+    runSeconds(5);
+    TEST_ASSERT_EQUAL_UINT8(1, fired);
+
+    // Uhr springt weit nach vorn: veralteter Termin wird übersprungen
+    fired = 0;
+    nativeMicros = 0;
+    nativeSetTime(localTime(2026, 10, 20, 6, 50));
+    scheduleBegin(onFire);
+    runSeconds(5);
+    nativeSetTime(localTime(2026, 10, 20, 7, 30));
+    runSeconds(5);
+    TEST_ASSERT_EQUAL_UINT8(0, fired);
+}
+
+void test_waits_for_ntp_time()
+{
+    scheduleConfig.entries[0] = entry(SCHED_FIXED, 0);
+    strcpy(scheduleConfig.ntp_server, "ntp.example.org");
+    nativeMicros = 0;
+    nativeClearTime();
+    scheduleBegin(onFire);
+    TEST_ASSERT_EQUAL_STRING("ntp.example.org", nativeNtpServer.c_str());
+
+    // ohne Uhrzeit ruht die Zeitsteuerung
+    runSeconds(60);
+    TEST_ASSERT_FALSE(scheduleRunning());
+
+    nativeSetTime(localTime(2026, 10, 19, 12, 0));
+    runSeconds(2);
+    TEST_ASSERT_TRUE(scheduleRunning());
+    TEST_ASSERT_EQUAL_UINT8(0, fired);
+}
+
+void test_restart_after_fire_does_not_repeat()
+{
+    scheduleConfig.entries[0] = entry(SCHED_FIXED, 7 * 60);
+    nativeMicros = 0;
+    nativeSetTime(localTime(2026, 10, 19, 6, 59));
+    scheduleBegin(onFire);
+    runSeconds(2 * 60);
+    TEST_ASSERT_EQUAL_UINT8(1, fired);
+
+    // Neustart um 07:03 (z.B. Konfiguration gespeichert), Uhrzeit erst nach einigen Sekunden
+    restart();
+    runSeconds(5);
+    nativeSetTime(localTime(2026, 10, 19, 7, 3));
+    runSeconds(10 * 60);
+    TEST_ASSERT_EQUAL_UINT8(1, fired);
+
+    // am nächsten Tag wieder
+    nativeSetTime(localTime(2026, 10, 20, 6, 59));
+    runSeconds(2 * 60);
+    TEST_ASSERT_EQUAL_UINT8(2, fired);
+}
+
+void test_restart_before_fire_catches_up_once()
+{
+    scheduleConfig.entries[0] = entry(SCHED_FIXED, 7 * 60);
+    scheduleConfig.entries[1] = entry(SCHED_FIXED, 6 * 60);
+    nativeMicros = 0;
+    nativeSetTime(localTime(2026, 10, 19, 5, 59));
+    scheduleBegin(onFire);
+    runSeconds(2 * 60);
+    TEST_ASSERT_EQUAL_UINT8(1, fired);
+
+    // Neustart kurz vor 07:00, die Uhrzeit kommt erst danach: 07:00 wird nachgeholt, 06:00 nicht
+    restart();
+    runSeconds(30);
+    nativeSetTime(localTime(2026, 10, 19, 7, 1));
+    runSeconds(5 * 60);
+    TEST_ASSERT_EQUAL_UINT8(2, fired);
+}
+
+void test_changed_schedule_discards_rtc_state()
+{
+    scheduleConfig.entries[0] = entry(SCHED_FIXED, 7 * 60);
+    nativeMicros = 0;
+    nativeSetTime(localTime(2026, 10, 19, 6, 59));
+    scheduleBegin(onFire);
+    runSeconds(2 * 60);
+    TEST_ASSERT_EQUAL_UINT8(1, fired);
+
+    // neuer Termin 07:02 gespeichert, Neustart um 07:03: der neue Termin wird nachgeholt
+    scheduleConfig.entries[0] = entry(SCHED_FIXED, 7 * 60 + 2);
+    restart();
+    nativeSetTime(localTime(2026, 10, 19, 7, 3));
+    runSeconds(5);
+    TEST_ASSERT_EQUAL_UINT8(2, fired);
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_days_from_civil);
+    RUN_TEST(test_sun_mid_latitudes);
+    RUN_TEST(test_sun_event_on_other_utc_day);
+    RUN_TEST(test_sun_polar_day_and_night);
+    RUN_TEST(test_fixed_time_across_dst);
+    RUN_TEST(test_weekday_mask);
+    RUN_TEST(test_sunrise_follows_sun_not_clock_change);
+    RUN_TEST(test_sunrise_southern_hemisphere_local_date);
+    RUN_TEST(test_sunrise_skips_polar_days);
+    RUN_TEST(test_loop_fires_once_despite_clock_jump_back);
+    RUN_TEST(test_loop_catches_up_within_grace_only);
+    RUN_TEST(test_waits_for_ntp_time);
+    RUN_TEST(test_restart_after_fire_does_not_repeat);
+    RUN_TEST(test_restart_before_fire_catches_up_once);
+    RUN_TEST(test_changed_schedule_discards_rtc_state);
+    return UNITY_END();
+}
@@ -0,0 +1,637 @@
+// Discrete-Event-Simulation der Firmware im Steuerungsmodus (pio test -e native -f test_soak)
+//
+// Ablaufsteuerung (control), Zeitsteuerung (scheduler) und Historie laufen unverändert gegen
+// eine virtuelle Uhr. WLAN, NTP, homee und die Tastenausgänge sind Modelle: der Access Point
+// fällt nach einem Skript aus, die Uhrzeit kommt erst nach der Verbindung, homee schickt Befehle
+// nur bei bestehender Verbindung, und ein GPIO-Beobachter prüft jeden Tastendruck. Ein Neustart
+// verhält sich wie auf dem ESP: RAM und Systemuhr sind weg, der RTC-Speicher bleibt, und
+// setup() baut die Verbindung über control.cpp neu auf. Ein simulierter Monat läuft in wenigen
+// Sekunden, millis() läuft dabei einmal über.
+//
+// Invarianten: kein angenommener Befehl geht verloren oder wird doppelt/in falscher Reihenfolge
+// ausgeführt, begrenzte Latenz, keine überlappenden Pulse, Mindestpause eingehalten, Neustart
+// nur ohne WLAN und ohne Uhrzeit, WLAN-Prüfung und Reconnect-Abstände auch über den Überlauf.
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <unity.h>
+
+#include <chrono>
+#include <deque>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "control.h"
+#include "history.h"
+#include "scheduler.h"
+
+const uint64_t PULSE_MS = 500;
+const uint64_t GAP_MS = 200;
+const uint64_t ASSOC_MS = 3000;                       // Assoziierung nach WiFi.reconnect()
+const uint64_t NTP_DELAY_MS = 1000;                   // Uhrzeit nach der Verbindung
+const uint64_t BUSY_STEP_MS = 10;                     // loop()-Takt bei anstehenden Befehlen
+const uint64_t OFFLINE_STEP_MS = 100;
+const uint64_t IDLE_STEP_MS = 1000;
+const uint32_t START_MILLIS = 0xFFFFFFFFUL - 3600000; // millis() läuft nach einer Stunde über
+const time_t START_TIME = 1790805600;                  // 2026-10-01 00:00 MESZ
+const uint64_t DAY_MS = 86400ULL * 1000;
+
+// alle Reconnect-Versuche ausgeschöpft; ohne Uhrzeit würde danach neu gestartet
+const uint64_t RECONNECT_EXHAUSTED_MS = WIFI_MAX_RECONNECT_ATTEMPTS * WIFI_RECONNECT_INTERVAL;
+
+// Verbindungsaufbau nach dem Start, danach ohne Uhrzeit Neustart
+const uint64_t BOOT_CONNECT_MS = WIFI_BOOT_ATTEMPTS * WIFI_BOOT_CHECK_INTERVAL;
+
+// ein Befehl wartet höchstens auf alle vor ihm stehenden Pulse samt Pause
+const uint64_t MAX_LATENCY_MS = (CMD_QUEUE_SIZE - 1) * (PULSE_MS + GAP_MS) + BUSY_STEP_MS;
+
+enum EventType : uint8_t
+{
+    EV_HOMEE,       // Befehl von homee
+    EV_AP_DOWN,
+    EV_AP_UP,
+    EV_DISABLE,
+    EV_ENABLE,
+    EV_CRASH        // Neustart von außen (Absturz, OTA), RAM-Inhalt geht verloren
+};
+
+struct Event
+{
+    uint64_t time;
+    uint8_t type;
+    uint8_t command;
+    bool operator>(const Event& other) const { return time > other.time; }
+};
+
+struct Pending
+{
+    uint64_t submitted;
+    uint8_t command;
+};
+
+struct Sim
+{
+    // WLAN-Modell
+    bool apUp;
+    uint64_t apChangedAt;
+    bool linkUp;
+    bool associating;
+    uint64_t assocStart;
+    uint64_t linkUpAt;
+    bool awaitingRecovery;
+    uint64_t lastCheck;
+    uint64_t maxCheckGap;
+    uint64_t lastReconnect;
+    uint64_t minReconnectGap;
+    uint64_t maxRecovery;
+    uint32_t reconnects;
+    uint32_t restarts;
+    uint64_t lastRestart;
+    uint64_t minRestartGap;
+    uint32_t badRestarts;
+    uint32_t crashes;
+    uint32_t lostOnCrash;
+
+    // Start und Uhrzeit
+    uint64_t startMs;
+    bool clockSet;
+    bool onlineThisBoot;
+    uint32_t onlines;
+    uint32_t doubleOnlines;
+
+    // GPIO-Beobachter
+    bool pulseActive;
+    uint64_t pulseEnd;
+    uint64_t lastPulseEnd;
+    uint32_t pulses;
+    uint32_t overlaps;
+    uint32_t gapViolations;
+
+    // Befehle
+    bool disabled;
+    std::deque<Pending> pending;
+    uint64_t maxLatency;
+    uint32_t submitted;
+    uint32_t rejected;
+    uint32_t dropped;
+    uint32_t lost;
+    uint32_t mismatches;
+    uint32_t undelivered;
+    uint32_t scheduleFired;
+};
+
+static Sim sim;
+static std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+
+static uint64_t simNow()
+{
+    return nativeMicros / 1000;
+}
+
+static void updateLink()
+{
+    if (sim.associating && sim.apUp && simNow() - max(sim.assocStart, sim.apChangedAt) >= ASSOC_MS)
+    {
+        sim.associating = false;
+        sim.linkUp = true;
+        sim.linkUpAt = simNow();
+        if (sim.awaitingRecovery)
+        {
+            sim.awaitingRecovery = false;
+            sim.maxRecovery = max(sim.maxRecovery, simNow() - sim.apChangedAt);
+        }
+    }
+}
+
+// Unix-Zeit der Simulation, unabhängig von der Systemuhr des Geräts
+static time_t trueTime()
+{
+    return START_TIME + (time_t)((simNow() - sim.startMs) / 1000);
+}
+
+static uint64_t simTimeOf(time_t t)
+{
+    return sim.startMs + (uint64_t)(t - START_TIME) * 1000;
+}
+
+static void submit(uint8_t command, uint8_t source)
+{
+    sim.submitted++;
+    if (controlSubmit(command, source))
+    {
+        sim.pending.push_back({ simNow(), command });
+    }
+    else if (sim.disabled && command != CMD_STOP)
+    {
+        sim.rejected++;
+    }
+    else
+    {
+        sim.dropped++;
+    }
+}
+
+static void onSchedule(uint8_t command)
+{
+    sim.scheduleFired++;
+    submit(command, HIST_SRC_SCHEDULE);
+}
+
+// --- Hardware-Modelle hinter ControlHal ---
+
+static bool simWifiConnected()
+{
+    updateLink();
+    if (sim.lastCheck != 0)
+    {
+        sim.maxCheckGap = max(sim.maxCheckGap, simNow() - sim.lastCheck);
+    }
+    sim.lastCheck = simNow();
+    return sim.linkUp;
+}
+
+static void simWifiBegin()
+{
+    sim.associating = true;
+    sim.assocStart = simNow();
+}
+
+static void simOnline()
+{
+    if (sim.onlineThisBoot)
+    {
+        sim.doubleOnlines++;
+    }
+    sim.onlineThisBoot = true;
+    sim.onlines++;
+}
+
+static void simWifiReconnect()
+{
+    // ein neuer Aufruf bricht eine laufende Assoziierung ab
+    if (sim.lastReconnect != 0)
+    {
+        sim.minReconnectGap = min(sim.minReconnectGap, simNow() - sim.lastReconnect);
+    }
+    sim.lastReconnect = simNow();
+    sim.reconnects++;
+    sim.associating = true;
+    sim.assocStart = simNow();
+}
+
+static void boot();
+
+static void simRestart()
+{
+    // nur ohne WLAN und nur, solange die Zeitsteuerung nicht auf der internen Uhr weiterläuft
+    sim.restarts++;
+    if (scheduleRunning() || (sim.apUp && simNow() - sim.apChangedAt >= BOOT_CONNECT_MS))
+    {
+        sim.badRestarts++;
+    }
+    if (sim.lastRestart != 0)
+    {
+        sim.minRestartGap = min(sim.minRestartGap, simNow() - sim.lastRestart);
+    }
+    sim.lastRestart = simNow();
+    sim.lost += sim.pending.size();
+    sim.pending.clear();
+    historyFlush();
+    boot();
+}
+
+static bool simPulseReady()
+{
+    if (sim.pulseActive && simNow() >= sim.pulseEnd)
+    {
+        sim.pulseActive = false;
+        sim.lastPulseEnd = sim.pulseEnd;
+    }
+    return !sim.pulseActive && simNow() - sim.lastPulseEnd >= GAP_MS;
+}
+
+static void simPress(uint8_t command)
+{
+    if (sim.pulseActive)
+    {
+        sim.overlaps++;
+    }
+    if (simNow() - sim.lastPulseEnd < GAP_MS)
+    {
+        sim.gapViolations++;
+    }
+    if (sim.pending.empty() || sim.pending.front().command != command)
+    {
+        sim.mismatches++;
+    }
+    else
+    {
+        sim.maxLatency = max(sim.maxLatency, simNow() - sim.pending.front().submitted);
+        sim.pending.pop_front();
+    }
+    sim.pulses++;
+    sim.pulseActive = true;
+    sim.pulseEnd = simNow() + PULSE_MS;
+}
+
+static void simLedOff()
+{
+}
+
+static void simLedToggle()
+{
+}
+
+static const ControlHal simHal = {
+    simWifiBegin, simOnline, scheduleRunning, simWifiConnected, simWifiReconnect, simRestart,
+    simPulseReady, simPress, simLedOff, simLedToggle
+};
+
+// setup() des Steuerungsmodus nach einem Neustart: Systemuhr und RAM-Zustand sind verloren,
+// der RTC-Speicher (lastFire der Zeitsteuerung) bleibt; "disabled" setzt homee erst wieder
+static void boot()
+{
+    nativeClearTime();
+    sim.clockSet = false;
+    sim.onlineThisBoot = false;
+    sim.disabled = false;
+    sim.associating = false;
+    historyBegin();
+    scheduleBegin(onSchedule);
+    sim.linkUp = false;
+    sim.lastCheck = 0;
+    sim.lastReconnect = 0;
+    sim.pulseActive = false;
+    sim.lastPulseEnd = simNow() - GAP_MS;
+    controlBegin(simHal);
+}
+
+static void handle(const Event& e)
+{
+    switch (e.type)
+    {
+        case EV_HOMEE:
+            updateLink();
+            if (sim.linkUp && sim.onlineThisBoot)
+            {
+                submit(e.command, HIST_SRC_HOMEE);
+            }
+            else
+            {
+                sim.undelivered++; // homee erreicht das Gerät nicht, kein Fehler der Firmware
+            }
+            break;
+        case EV_AP_DOWN:
+            sim.apUp = false;
+            sim.linkUp = false;
+            sim.apChangedAt = simNow();
+            break;
+        case EV_AP_UP:
+            sim.apUp = true;
+            sim.apChangedAt = simNow();
+            sim.awaitingRecovery = true;
+            break;
+        case EV_DISABLE:
+        case EV_ENABLE:
+            sim.disabled = (e.type == EV_DISABLE);
+            controlSetDisabled(sim.disabled);
+            break;
+        case EV_CRASH:
+            sim.crashes++;
+            sim.lostOnCrash += sim.pending.size();
+            sim.pending.clear();
+            boot();
+            break;
+    }
+}
+
+// loop() bis 'end' ausführen; der Takt richtet sich nach dem Zustand, Ereignisse werden
+// genau zu ihrem Zeitpunkt eingespielt
+static void runUntil(uint64_t end)
+{
+    while (simNow() < end)
+    {
+        while (!events.empty() && events.top().time <= simNow())
+        {
+            handle(events.top());
+            events.pop();
+        }
+
+        // NTP: die Uhrzeit kommt kurz nach der Verbindung
+        if (sim.linkUp && !sim.clockSet && simNow() - sim.linkUpAt >= NTP_DELAY_MS)
+        {
+            nativeSetTime(trueTime());
+            sim.clockSet = true;
+        }
+
+        scheduleLoop();
+        controlLoop();
+        historyLoop();
+
+        bool busy = !sim.pending.empty() || sim.pulseActive;
+        uint64_t next = simNow() + (busy ? BUSY_STEP_MS : (sim.linkUp ? IDLE_STEP_MS : OFFLINE_STEP_MS));
+        if (!events.empty() && events.top().time < next)
+        {
+            next = max(events.top().time, simNow() + 1);
+        }
+        nativeMicros = min(next, end) * 1000;
+    }
+}
+
+static void addEvent(uint64_t time, uint8_t type, uint8_t command = 0)
+{
+    events.push({ time, type, command });
+}
+
+// Einschalten: RTC-Speicher mit Zufallsinhalt, keine Uhrzeit
+static void startSim()
+{
+    sim = Sim();
+    sim.apUp = true;
+    sim.minReconnectGap = UINT64_MAX;
+    sim.minRestartGap = UINT64_MAX;
+    events = decltype(events)();
+
+    LittleFS.nativeFormat();
+    nativeRtcClear();
+    memset(&scheduleConfig, 0, sizeof(scheduleConfig));
+    scheduleConfig.latitude = 52.52f;
+    scheduleConfig.longitude = 13.40f;
+    strcpy(scheduleConfig.timezone, "CET-1CEST,M3.5.0,M10.5.0/3");
+    scheduleConfig.entries[0] = { SCHED_SUNRISE, CMD_UP, SCHEDULE_ALL_DAYS, 0, 0 };
+    scheduleConfig.entries[1] = { SCHED_FIXED, CMD_STOP, SCHEDULE_ALL_DAYS, 0, 12 * 60 + 30 };
+    scheduleConfig.entries[2] = { SCHED_SUNSET, CMD_DOWN, SCHEDULE_ALL_DAYS, 0, 15 };
+
+    nativeMicros = (uint64_t)START_MILLIS * 1000;
+    sim.startMs = simNow();
+    boot();
+}
+
+// Termin eines Eintrags am Tag 'day' der Simulation
+static uint64_t entryTime(uint8_t entry, uint64_t day)
+{
+    return simTimeOf(scheduleNextFire(scheduleConfig.entries[entry], START_TIME + (time_t)day * 86400));
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_month_of_operation()
+{
+    startSim();
+    const uint64_t start = simNow();
+    const uint64_t days = 31;
+    const uint64_t end = start + days * DAY_MS;
+    std::mt19937 rng(2026);
+
+    // homee: im Mittel alle 15 min 1-4 Befehle kurz hintereinander (Finger auf der App)
+    std::exponential_distribution<double> burstGap(1.0 / (15 * 60 * 1000));
+    std::uniform_int_distribution<int> burstSize(1, 4);
+    std::uniform_int_distribution<int> commandDist(CMD_UP, CMD_STOP);
+    std::uniform_int_distribution<int> tapGap(0, 800);
+    for (uint64_t t = start + 60000; t < end; t += (uint64_t)burstGap(rng) + 1)
+    {
+        uint64_t at = t;
+        for (int i = burstSize(rng); i > 0; i--)
+        {
+            addEvent(at, EV_HOMEE, (uint8_t)commandDist(rng));
+            at += tapGap(rng);
+        }
+    }
+
+    // kurze WLAN-Ausfälle (im Mittel alle 6 h, bis 80 s) und nachts ein langer Ausfall alle 10 Tage
+    std::exponential_distribution<double> dropGap(1.0 / (6 * 3600 * 1000.0));
+    std::uniform_int_distribution<int> dropLength(1000, 80000);
+    for (uint64_t t = start + (uint64_t)dropGap(rng); t < end; t += (uint64_t)dropGap(rng) + 120000)
+    {
+        addEvent(t, EV_AP_DOWN);
+        addEvent(t + dropLength(rng), EV_AP_UP);
+    }
+    for (uint64_t day = 5; day < days; day += 10)
+    {
+        uint64_t t = start + day * DAY_MS + 3 * 3600 * 1000;
+        addEvent(t, EV_AP_DOWN);
+        addEvent(t + 15 * 60 * 1000, EV_AP_UP);
+    }
+    // am Tag 15 startet das Gerät während des Ausfalls neu: ohne Uhrzeit Neustarts bis zum AP
+    addEvent(start + 15 * DAY_MS + (3 * 60 + 5) * 60000ULL, EV_CRASH);
+
+    // lange Ausfälle über Sonnenaufgang (Tag 12) und Sonnenuntergang (Tag 22): die Termine
+    // laufen auf der internen Uhr
+    uint64_t sunrise = entryTime(0, 12);
+    addEvent(sunrise - 5 * 60000, EV_AP_DOWN);
+    addEvent(sunrise + 10 * 60000, EV_AP_UP);
+    uint64_t sunset = entryTime(2, 22);
+    addEvent(sunset - 30 * 60000, EV_AP_DOWN);
+    addEvent(sunset + 90 * 60000, EV_AP_UP);
+
+    // Neustart 3 min nach dem Termin 12:30 (nicht wiederholen) und 1 s davor (nachholen)
+    for (uint64_t day = 7; day < days; day += 10)
+    {
+        addEvent(entryTime(1, day) + 3 * 60000, EV_CRASH);
+    }
+    addEvent(entryTime(1, 9) - 1000, EV_CRASH);
+
+    // Grenze der Zeitsteuerung: Neustart während eines Ausfalls über den Sonnenuntergang, der AP
+    // kommt erst nach der Kulanzzeit zurück. Ohne Uhrzeit entfällt dieser Termin.
+    sunset = entryTime(2, 25);
+    addEvent(sunset - 10 * 60000, EV_AP_DOWN);
+    addEvent(sunset - 5 * 60000, EV_CRASH);
+    addEvent(sunset + 20 * 60000, EV_AP_UP);
+    const uint32_t missedEntries = 1;
+
+    // jeden dritten Tag nachmittags eine Stunde "disabled"
+    for (uint64_t day = 1; day < days; day += 3)
+    {
+        addEvent(start + day * DAY_MS + 14 * 3600 * 1000, EV_DISABLE);
+        addEvent(start + day * DAY_MS + 15 * 3600 * 1000, EV_ENABLE);
+    }
+
+    uint32_t startMillis = millis();
+    NativeFsStats fsBefore = nativeFsStats;
+    auto wallStart = std::chrono::steady_clock::now();
+    runUntil(end);
+    // Rest der Warteschlange abarbeiten
+    runUntil(simNow() + MAX_LATENCY_MS + GAP_MS);
+    double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wallStart).count();
+
+    char msg[256];
+    snprintf(msg, sizeof(msg), "%lu days in %.0f ms: %lu commands, %lu pulses, %lu rejected, %lu undelivered, "
+             "%lu reconnects, %lu crashes, %lu restarts, max latency %lu ms, %lu flash writes",
+             (unsigned long)days, wallMs, (unsigned long)sim.submitted, (unsigned long)sim.pulses,
+             (unsigned long)sim.rejected, (unsigned long)sim.undelivered, (unsigned long)sim.reconnects,
+             (unsigned long)sim.crashes, (unsigned long)sim.restarts, (unsigned long)sim.maxLatency,
+             (unsigned long)(nativeFsStats.writes - fsBefore.writes));
+    TEST_MESSAGE(msg);
+
+    // millis() ist übergelaufen
+    TEST_ASSERT_TRUE(millis() < startMillis);
+
+    // keine verlorenen, doppelten oder vertauschten Befehle
+    TEST_ASSERT_EQUAL_UINT32(0, sim.lost);
+    TEST_ASSERT_EQUAL_UINT32(0, sim.mismatches);
+    TEST_ASSERT_EQUAL_UINT32(0, sim.dropped);
+    TEST_ASSERT_EQUAL(0, sim.pending.size());
+    TEST_ASSERT_EQUAL_UINT32(sim.submitted - sim.rejected - sim.lostOnCrash, sim.pulses);
+    TEST_ASSERT_TRUE(sim.rejected > 0);
+
+    // Zeitsteuerung: jeder der drei Einträge genau einmal pro Tag, auch bei Ausfällen und
+    // Neustarts, außer ohne Uhrzeit
+    TEST_ASSERT_EQUAL_UINT32(3 * days - missedEntries, sim.scheduleFired);
+
+    // Tastenausgänge
+    TEST_ASSERT_EQUAL_UINT32(0, sim.overlaps);
+    TEST_ASSERT_EQUAL_UINT32(0, sim.gapViolations);
+    TEST_ASSERT_LESS_OR_EQUAL(MAX_LATENCY_MS, sim.maxLatency);
+
+    // WLAN: Neustart nur ohne Uhrzeit (nach den Abstürzen im Ausfall), homee je Start einmal
+    // eingerichtet, Prüfung alle 30 s auch über den Überlauf hinweg, Reconnect-Versuche nie
+    // dichter als 5 s, nach Rückkehr des AP schnell wieder verbunden
+    TEST_ASSERT_TRUE(sim.restarts > 0);
+    TEST_ASSERT_EQUAL_UINT32(0, sim.badRestarts);
+    TEST_ASSERT_GREATER_OR_EQUAL(BOOT_CONNECT_MS, sim.minRestartGap);
+    TEST_ASSERT_EQUAL_UINT32(0, sim.doubleOnlines);
+    TEST_ASSERT_GREATER_OR_EQUAL(sim.crashes + 1, sim.onlines);
+    TEST_ASSERT_LESS_OR_EQUAL(WIFI_CHECK_INTERVAL + IDLE_STEP_MS, sim.maxCheckGap);
+    TEST_ASSERT_GREATER_OR_EQUAL(WIFI_RECONNECT_INTERVAL, sim.minReconnectGap);
+    TEST_ASSERT_LESS_OR_EQUAL(WIFI_CHECK_INTERVAL + ASSOC_MS + IDLE_STEP_MS, sim.maxRecovery);
+}
+
+void test_burst_overflow_is_reported_not_lost()
+{
+    startSim();
+    runUntil(simNow() + 10000);
+
+    // mehr Befehle auf einmal als in die Warteschlange passen
+    for (uint8_t i = 0; i < CMD_QUEUE_SIZE + 2; i++)
+    {
+        addEvent(simNow(), EV_HOMEE, i % 3);
+    }
+    runUntil(simNow() + 20000);
+
+    TEST_ASSERT_EQUAL_UINT32(CMD_QUEUE_SIZE - 1, sim.pulses);
+    TEST_ASSERT_EQUAL_UINT32(3, sim.dropped);
+    TEST_ASSERT_EQUAL_UINT32(0, sim.mismatches);
+    TEST_ASSERT_EQUAL_UINT32(0, sim.overlaps);
+    TEST_ASSERT_EQUAL(0, sim.pending.size());
+
+    // verworfene Befehle stehen in der Historie
+    historyFlush();
+    HistoryCursor cursor;
+    HistoryRecord records[16];
+    historyQuery(0, UINT32_MAX, cursor);
+    size_t n = historyRead(cursor, records, 16);
+    uint32_t droppedRecords = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        droppedRecords += (records[i].result == HIST_RES_DROPPED);
+    }
+    TEST_ASSERT_EQUAL_UINT32(3, droppedRecords);
+}
+
+void test_long_outage_keeps_schedule_running()
+{
+    startSim();
+    // Ausfall von 12:25 bis 12:45 über den Eintrag 12:30 (STOP)
+    uint64_t down = simNow() + (12 * 60 + 25) * 60000ULL;
+    addEvent(down, EV_AP_DOWN);
+    addEvent(down + 20 * 60 * 1000, EV_AP_UP);
+    runUntil(down);
+    uint32_t fired = sim.scheduleFired;
+    uint32_t pulses = sim.pulses;
+
+    runUntil(down + RECONNECT_EXHAUSTED_MS + WIFI_CHECK_INTERVAL + WIFI_RECONNECT_INTERVAL);
+    TEST_ASSERT_FALSE(sim.linkUp);
+    runUntil(down + 20 * 60 * 1000 - 1000);
+    TEST_ASSERT_EQUAL_UINT32(0, sim.restarts);
+    TEST_ASSERT_EQUAL_UINT32(fired + 1, sim.scheduleFired);
+    TEST_ASSERT_EQUAL_UINT32(pulses + 1, sim.pulses);
+
+    // nach Rückkehr des AP wieder verbunden, ohne Neustart
+    runUntil(simNow() + WIFI_RECONNECT_INTERVAL + ASSOC_MS + IDLE_STEP_MS);
+    TEST_ASSERT_TRUE(sim.linkUp);
+    TEST_ASSERT_EQUAL_UINT32(0, sim.restarts);
+    TEST_ASSERT_EQUAL_UINT32(1, sim.onlines);
+}
+
+void test_power_on_without_wifi_restarts_until_ap_returns()
+{
+    startSim();
+    addEvent(simNow(), EV_AP_DOWN);
+    uint64_t up = simNow() + 5 * 60 * 1000;
+    addEvent(up, EV_AP_UP);
+
+    // ohne Uhrzeit kann die Zeitsteuerung nicht laufen: Neustart nach jedem Verbindungsaufbau
+    runUntil(up);
+    TEST_ASSERT_TRUE(sim.restarts >= (up - sim.startMs) / BOOT_CONNECT_MS - 2);
+    TEST_ASSERT_GREATER_OR_EQUAL(BOOT_CONNECT_MS, sim.minRestartGap);
+    TEST_ASSERT_EQUAL_UINT32(0, sim.onlines);
+    TEST_ASSERT_FALSE(scheduleRunning());
+
+    // AP zurück: verbunden, homee eingerichtet, Uhrzeit da, keine weiteren Neustarts
+    runUntil(up + BOOT_CONNECT_MS + ASSOC_MS + NTP_DELAY_MS + 2 * IDLE_STEP_MS);
+    uint32_t restarts = sim.restarts;
+    TEST_ASSERT_TRUE(sim.linkUp);
+    TEST_ASSERT_EQUAL_UINT32(1, sim.onlines);
+    TEST_ASSERT_TRUE(scheduleRunning());
+    runUntil(simNow() + DAY_MS);
+    TEST_ASSERT_EQUAL_UINT32(restarts, sim.restarts);
+    TEST_ASSERT_EQUAL_UINT32(0, sim.badRestarts);
+    TEST_ASSERT_EQUAL_UINT32(3, sim.scheduleFired);
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_month_of_operation);
+    RUN_TEST(test_burst_overflow_is_reported_not_lost);
+    RUN_TEST(test_long_outage_keeps_schedule_running);
+    RUN_TEST(test_power_on_without_wifi_restarts_until_ap_returns);
+    return UNITY_END();
+}